@@ -20,6 +20,7 @@
 #ifndef KIWIX_BOOK_H
 #define KIWIX_BOOK_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include <memory>
@@ -38,6 +39,8 @@ namespace kiwix
 {
 
 class OPDSDumper;
+class BinaryReader;
+class BinaryWriter;
 
 /**
  * A class to store information about a book (a zim file)
@@ -71,6 +74,11 @@ class Book
   void update(const zim::Archive& archive);
   void updateFromXml(const pugi::xml_node& node, const std::string& baseDir);
   void updateFromOpds(const pugi::xml_node& node, const std::string& urlHost);
+
+  // The binary form of the books is used by the caches of the library.
+  // It can be read back only by the same build of libkiwix.
+  void updateFromBinary(BinaryReader& reader);
+  void writeBinary(BinaryWriter& writer) const;
   std::string getHumanReadableIdFromPath() const;
 
   bool readOnly() const { return m_readOnly; }
@@ -79,19 +87,19 @@ class Book
   bool isPathValid() const { return m_pathValid; }
   const std::string& getTitle() const { return m_title; }
   const std::string& getDescription() const { return m_description; }
-  DEPRECATED const std::string& getLanguage() const { return m_language; }
-  const std::string& getCommaSeparatedLanguages() const { return m_language; }
-  const std::vector<std::string> getLanguages() const;
-  const std::string& getCreator() const { return m_creator; }
-  const std::string& getPublisher() const { return m_publisher; }
+  DEPRECATED const std::string& getLanguage() const { return m_languages->str; }
+  const std::string& getCommaSeparatedLanguages() const { return m_languages->str; }
+  const std::vector<std::string>& getLanguages() const { return m_languages->list; }
+  const std::string& getCreator() const { return *m_creator; }
+  const std::string& getPublisher() const { return *m_publisher; }
   const std::string& getDate() const { return m_date; }
   const std::string& getUrl() const { return m_url; }
   const std::string& getName() const { return m_name; }
-  std::string getCategory() const;
-  const std::string& getTags() const { return m_tags; }
+  const std::string& getCategory() const { return *m_category; }
+  const std::string& getTags() const { return m_tags->str; }
   std::string getTagStr(const std::string& tagName) const;
   bool getTagBool(const std::string& tagName) const;
-  const std::string& getFlavour() const { return m_flavour; }
+  const std::string& getFlavour() const { return *m_flavour; }
   const std::string& getOrigId() const { return m_origId; }
   const uint64_t& getArticleCount() const { return m_articleCount; }
   const uint64_t& getMediaCount() const { return m_mediaCount; }
@@ -111,21 +119,43 @@ class Book
   void setPathValid(bool valid) { m_pathValid = valid; }
   void setTitle(const std::string& title) { m_title = title; }
   void setDescription(const std::string& description) { m_description = description; }
-  void setLanguage(const std::string& language) { m_language = language; }
-  void setCreator(const std::string& creator) { m_creator = creator; }
-  void setPublisher(const std::string& publisher) { m_publisher = publisher; }
+  void setLanguage(const std::string& language);
+  void setCreator(const std::string& creator);
+  void setPublisher(const std::string& publisher);
   void setDate(const std::string& date) { m_date = date; }
   void setUrl(const std::string& url) { m_url = url; }
   void setName(const std::string& name) { m_name = name; }
-  void setFlavour(const std::string& flavour) { m_flavour = flavour; }
-  void setTags(const std::string& tags) { m_tags = tags; }
+  void setFlavour(const std::string& flavour);
+  void setTags(const std::string& tags);
   void setOrigId(const std::string& origId) { m_origId = origId; }
   void setArticleCount(uint64_t articleCount) { m_articleCount = articleCount; }
   void setMediaCount(uint64_t mediaCount) { m_mediaCount = mediaCount; }
   void setSize(uint64_t size) { m_size = size; }
   void setDownloadId(const std::string& downloadId) { m_downloadId = downloadId; }
 
+ private: // types
+  // The values of the attributes that are the same for many books are
+  // interned: the books having the same value of such an attribute share
+  // one immutable copy of it (along with its parsed form, if any).
+  template<class T> using Interned = std::shared_ptr<const T>;
+
+  struct Languages
+  {
+    std::string str;
+    std::vector<std::string> list;
+  };
+
+  struct Tags
+  {
+    std::string str;
+    // The values of the "_<name>:<value>" tags (see convertTags())
+    std::map<std::string, std::string> values;
+  };
+
  private: // functions
+  static Languages parseLanguages(const std::string& languages);
+  static Tags parseTags(const std::string& tags);
+  void setCategory(const std::string& category);
   std::string getCategoryFromTags() const;
   const Illustration& getDefaultIllustration() const;
 
@@ -136,15 +166,15 @@ class Book
   bool m_pathValid = false;
   std::string m_title;
   std::string m_description;
-  std::string m_category;
-  std::string m_language;
-  std::string m_creator;
-  std::string m_publisher;
+  Interned<std::string> m_category;
+  Interned<Languages> m_languages;
+  Interned<std::string> m_creator;
+  Interned<std::string> m_publisher;
   std::string m_date;
   std::string m_url;
   std::string m_name;
-  std::string m_flavour;
-  std::string m_tags;
+  Interned<std::string> m_flavour;
+  Interned<Tags> m_tags;
   std::string m_origId;
   uint64_t m_articleCount = 0;
   uint64_t m_mediaCount = 0;
@@ -20,11 +20,13 @@
 #ifndef KIWIX_LIBRARY_H
 #define KIWIX_LIBRARY_H
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <zim/archive.h>
 #include <zim/search.h>
 
@@ -83,7 +85,10 @@ class Filter {
     std::string _lang;
     std::string _publisher;
     std::string _creator;
+    size_t _minSize;
     size_t _maxSize;
+    std::string _dateFrom;
+    std::string _dateTo;
     std::string _query;
     bool _queryIsPartial;
     std::string _name;
@@ -145,6 +150,34 @@ class Filter {
     Filter& publisher(std::string publisher);
     Filter& creator(std::string creator);
     Filter& maxSize(size_t size);
+
+    /**
+     *  Set the filter to only accept books at least as large as the given
+     *  size (in bytes).
+     */
+    Filter& minSize(size_t size);
+
+    /**
+     *  Set the filter to only accept books published on or after a date.
+     *
+     *  The date is in the YYYY-MM-DD format. A partial date (YYYY or
+     *  YYYY-MM) stands for the beginning of the period.
+     *
+     *  Throws std::invalid_argument if the date is not in one of those
+     *  formats.
+     */
+    Filter& dateFrom(std::string date);
+
+    /**
+     *  Set the filter to only accept books published on or before a date.
+     *
+     *  The date is in the YYYY-MM-DD format. A partial date (YYYY or
+     *  YYYY-MM) stands for the end of the period.
+     *
+     *  Throws std::invalid_argument if the date is not in one of those
+     *  formats.
+     */
+    Filter& dateTo(std::string date);
     Filter& query(std::string query, bool partial=true);
     Filter& name(std::string name);
     Filter& flavour(std::string flavour);
@@ -173,6 +206,18 @@ class Filter {
     bool hasFlavour() const;
     const std::string& getFlavour() const { return _flavour; }
 
+    bool hasMinSize() const;
+    size_t getMinSize() const { return _minSize; }
+
+    bool hasMaxSize() const;
+    size_t getMaxSize() const { return _maxSize; }
+
+    bool hasDateFrom() const;
+    const std::string& getDateFrom() const { return _dateFrom; }
+
+    bool hasDateTo() const;
+    const std::string& getDateTo() const { return _dateTo; }
+
     const Tags& getAcceptTags() const { return _acceptTags; }
     const Tags& getRejectTags() const { return _rejectTags; }
 
@@ -180,6 +225,8 @@ private: // functions
     friend class Library;
 
     bool accept(const Book& book) const;
+    bool hasBookAttributeConditions() const;
+    std::string getCanonicalForm() const;
 };
 
 
@@ -193,6 +240,9 @@ class ZimSearcher : public zim::Searcher
     std::unique_lock<std::mutex> getLock() {
       return std::unique_lock<std::mutex>(m_mutex);
     }
+    std::unique_lock<std::mutex> getLock(std::defer_lock_t) {
+      return std::unique_lock<std::mutex>(m_mutex, std::defer_lock);
+    }
     virtual ~ZimSearcher() = default;
   private:
     std::mutex m_mutex;
@@ -229,6 +279,37 @@ class Library: public std::enable_shared_from_this<Library>
   typedef std::map<std::string, int> AttributeCounts;
   typedef std::set<std::string> BookIdSet;
 
+  /**
+   * A page of the ids of the books accepted by a filter.
+   */
+  struct BookIdPage
+  {
+    // The ids of the books of the page
+    BookIdCollection bookIds;
+
+    // The count of all books accepted by the filter
+    size_t totalCount = 0;
+
+    // The index of the first book of the page among all accepted books
+    size_t startIndex = 0;
+
+    // An opaque cursor to pass to filterPageAfter() in order to get
+    // the next page (empty if this is the last page)
+    std::string nextCursor;
+  };
+
+  /**
+   * Statistics of the cache of the results of filter().
+   */
+  struct FilterCacheStats
+  {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+
+  class Snapshot;
+  typedef std::shared_ptr<const Snapshot> ConstSnapshotPtr;
+
  private:
   Library();
 
@@ -258,6 +339,19 @@ class Library: public std::enable_shared_from_this<Library>
    */
   bool addBook(const Book& book);
 
+  /**
+   * Add several books to the library at once.
+   *
+   * Same as calling addBook() for every book, except that the library is
+   * locked, its revision incremented and its caches resized only once
+   * (and not at all if there are no books).
+   *
+   * @param books The books to add.
+   * @return The ids of the books that have been added (the other books
+   *         have updated existing books), in the order of `books`.
+   */
+  BookIdCollection addBooks(const std::vector<Book>& books);
+
   /**
    * A self-explanatory alias for addBook()
    */
@@ -339,13 +433,48 @@ class Library: public std::enable_shared_from_this<Library>
    */
   std::string getBestTargetBookId(const std::string& bookName, const std::string& preferedFlavour="", const std::string& minDate="") const;
 
-  // XXX: This is a non-thread-safe operation
+  /**
+   * Get a book of the library.
+   *
+   * @deprecated This is a non-thread-safe operation: the returned reference
+   * is invalidated as soon as the book is updated or removed, possibly by
+   * another thread. Use getBookPtrById() (or getSnapshot()) instead.
+   *
+   * @param id the id of the book.
+   * @return The book.
+   * @throw std::out_of_range if there is no such book in the library.
+   */
   const Book& getBookById(const std::string& id) const;
   // XXX: This is a non-thread-safe operation
   const Book& getBookByPath(const std::string& path) const;
 
   Book getBookByIdThreadSafe(const std::string& id) const;
 
+  /**
+   * Get a book of the library without copying it.
+   *
+   * The book is shared with the library and is never modified. If the book
+   * is later updated in the library, the returned object keeps describing
+   * the previous state of the book.
+   *
+   * @param id the id of the book.
+   * @return The book.
+   * @throw std::out_of_range if there is no such book in the library.
+   */
+  std::shared_ptr<const Book> getBookPtrById(const std::string& id) const;
+
+  /**
+   * Get the current state of the books of the library.
+   *
+   * The snapshot is immutable, so it can be used by any thread without
+   * locking and for as long as needed. Later changes of the library are
+   * not reflected in it. Getting a snapshot never locks the library (the
+   * snapshots are made when the library is changed).
+   *
+   * @return A snapshot of the library.
+   */
+  ConstSnapshotPtr getSnapshot() const;
+
   std::shared_ptr<zim::Archive> getArchiveById(const std::string& id);
   std::shared_ptr<ZimSearcher> getSearcherById(const std::string& id) {
     return getSearcherByIds(BookIdSet{id});
@@ -360,6 +489,17 @@ class Library: public std::enable_shared_from_this<Library>
    */
   bool removeBookById(const std::string& id);
 
+  /**
+   * Remove several books from the library at once.
+   *
+   * The revision of the library is incremented only once (and not at all
+   * if none of the books were in the library).
+   *
+   * @param ids the ids of the books to remove.
+   * @return Count of books that were removed by this operation.
+   */
+  uint32_t removeBooksByIds(const BookIdCollection& ids);
+
   /**
    * Write the library to a file.
    *
@@ -437,15 +577,67 @@ class Library: public std::enable_shared_from_this<Library>
   /**
    * Filter the library and return the id of the keep elements.
    *
+   * The results are cached until the library is modified (the cache size
+   * is set by the KIWIX_FILTER_CACHE_SIZE environment variable).
+   *
    * @param filter The filter to use.
    * @return The list of bookIds corresponding to the filter.
    */
   BookIdCollection filter(const Filter& filter) const;
 
+  /**
+   * Get the hit and miss counts of the cache of the results of filter().
+   *
+   * @return The statistics of the cache.
+   */
+  FilterCacheStats getFilterCacheStats() const;
+
+  /**
+   * Filter the library and return one page of the ids of the keep elements.
+   *
+   * Unless another order is requested, the books are in the same order
+   * as in the result of filter(). Only the requested page of them is
+   * collected. Ordering by size or date is performed by the search index.
+   *
+   * Only pages of unsorted results have a nextCursor.
+   *
+   * @param filter The filter to use.
+   * @param start The index of the first book of the page.
+   * @param count The maximal number of books in the page.
+   * @param sortBy The order of the books.
+   * @param ascending Whether the order is ascending or descending.
+   * @return The requested page of the bookIds corresponding to the filter.
+   */
+  BookIdPage filterPage(const Filter& filter, size_t start, size_t count,
+                        supportedListSortBy sortBy = UNSORTED, bool ascending = true) const;
+
+  /**
+   * Filter the library and return the page following a previous page.
+   *
+   * When the filter has no conditions on the indexed data of the books
+   * (query, name, category, language, tags, etc), the next page starts
+   * right after the last book of the previous page even if books were
+   * added to or removed from the library in the meantime, and the cost of
+   * the operation doesn't depend on how deep the page is. Otherwise the
+   * page is located by its index.
+   *
+   * @param filter The filter used to get the previous page.
+   * @param cursor The nextCursor of the previous page.
+   * @param count The maximal number of books in the page.
+   * @return The requested page of the bookIds corresponding to the filter.
+   * @throw std::invalid_argument if the cursor is malformed.
+   */
+  BookIdPage filterPageAfter(const Filter& filter, const std::string& cursor, size_t count) const;
+
 
   /**
    * Sort (in place) bookIds using the given arguments.
    *
+   * Titles are compared the way a human would do it (e.g. ignoring the
+   * case), using the ICU collation of the root locale (they used to be
+   * compared byte by byte). Books with equal sort keys keep their relative
+   * order.
+   *
    * @param bookIds the list of book Ids to sort
    * @param sortBy how to sort the books (UNSORTED, TITLE, SIZE, DATE, CREATOR, PUBLISHER)
    * @param ascending ascending or descending
@@ -456,7 +648,7 @@ class Library: public std::enable_shared_from_this<Library>
    * Return the current revision of the library.
    *
    * The revision of the library is updated (incremented by one) by
-   * the addBook() and removeBookById() operations.
+   * the operations adding, updating or removing books.
    *
    * @return Current revision of the library.
    */
@@ -474,33 +666,147 @@ class Library: public std::enable_shared_from_this<Library>
   friend class libXMLDumper;
 
 private: // types
-  typedef const std::string& (Book::*BookStrPropMemFn)() const;
   struct Entry : Book
   {
     Library::Revision lastUpdatedRevision = 0;
+
+    // Collation key of the title (see getCollationKey())
+    std::string titleSortKey;
+  };
+
+  // The entries are never modified once they are in the map: an updated
+  // book gets a new entry, so that snapshots can share the entries.
+  typedef std::map<std::string, std::shared_ptr<const Entry>> EntryMap;
+
+  // Maps a property value to the ids of the books having it
+  typedef std::unordered_map<std::string, BookIdSet> BookIndex;
+
+  // The book counts of the library, maintained as books are added,
+  // updated and removed
+  struct Facets
+  {
+    unsigned int localBookCount = 0;
+    unsigned int remoteBookCount = 0;
+    unsigned int localOrRemoteBookCount = 0;
+
+    // The books having an origId are not counted in the languages,
+    // creators and publishers
+    AttributeCounts languages;
+    AttributeCounts categories;
+    AttributeCounts creators;
+    AttributeCounts publishers;
+
+    void add(const Book& book) { update(book, 1); }
+    void remove(const Book& book) { update(book, -1); }
+    unsigned int getBookCount(const bool localBooks, const bool remoteBooks) const;
+
+   private:
+    void update(const Book& book, int delta);
   };
 
 private: // functions
-  AttributeCounts getBookAttributeCounts(BookStrPropMemFn p) const;
-  std::vector<std::string> getBookPropValueSet(BookStrPropMemFn p) const;
-  BookIdCollection filterViaBookDB(const Filter& filter) const;
+  BookIdCollection filterViaBookDB(const Filter& filter, ConstSnapshotPtr& snapshot) const;
+  BookIdCollection filterNotCached(const Filter& filter) const;
+  BookIdPage getBookIdPage(const Filter& filter, size_t start, const std::string& lastBookId, size_t count,
+                           supportedListSortBy sortBy = UNSORTED, bool ascending = true) const;
   std::string getBestFromBookCollection(BookIdCollection books, const Bookmark& bookmark, MigrationMode migrationMode) const;
-  unsigned int getBookCount_not_protected(const bool localBooks, const bool remoteBooks) const;
-  void updateBookDB(const Book& book);
+  bool addOrUpdateEntry(const Book& book, const std::string& titleSortKey);
+  bool removeEntry(const std::string& id);
+  void updateCacheSizes();
+  void addToIndexes(const Book& book);
+  void removeFromIndexes(const Book& book);
   void dropCache(const std::string& bookId);
+  void publishSnapshot();
 
 private: //data
   mutable std::recursive_mutex m_mutex;
-  Library::Revision m_revision;
-  std::map<std::string, Entry> m_books;
+  std::atomic<Library::Revision> m_revision;
+  EntryMap m_books;
+  Facets m_facets;
+  BookIndex m_bookIdsByPath;
+  BookIndex m_bookIdsByName;
+  // Accessed only via std::atomic_load()/std::atomic_store()
+  ConstSnapshotPtr mp_snapshot;
   using ArchiveCache = ConcurrentCache<std::string, std::shared_ptr<zim::Archive>>;
   std::unique_ptr<ArchiveCache> mp_archiveCache;
   using SearcherCache = MultiKeyCache<std::string, std::shared_ptr<ZimSearcher>>;
   std::unique_ptr<SearcherCache> mp_searcherCache;
+  using FilterCache = ConcurrentCache<std::string, BookIdCollection>;
+  std::unique_ptr<FilterCache> mp_filterCache;
+  mutable std::atomic<uint64_t> m_filterCacheLookups{0};
+  mutable std::atomic<uint64_t> m_filterCacheMisses{0};
   std::vector<kiwix::Bookmark> m_bookmarks;
   std::unique_ptr<Xapian::WritableDatabase> m_bookDB;
 };
 
+/**
+ * An immutable state of the books of a library (see Library::getSnapshot()).
+ */
+class Library::Snapshot
+{
+ public:
+  Snapshot(Revision revision, const EntryMap& books, const Facets& facets);
+
+  /**
+   * Return the revision of the library this snapshot was taken at.
+   */
+  Revision getRevision() const { return m_revision; }
+
+  /**
+   * Get a book of the snapshot.
+   *
+   * The returned reference is valid as long as the snapshot exists.
+   *
+   * @param id the id of the book.
+   * @return The book.
+   * @throw std::out_of_range if there is no such book in the snapshot.
+   */
+  const Book& getBookById(const std::string& id) const;
+
+  /**
+   * Get a book of the snapshot without copying it.
+   *
+   * The returned book remains valid even after the snapshot is destroyed.
+   *
+   * @param id the id of the book.
+   * @return The book.
+   * @throw std::out_of_range if there is no such book in the snapshot.
+   */
+  std::shared_ptr<const Book> getBookPtrById(const std::string& id) const;
+
+  /**
+   * Get the revision of the last update of a book of the snapshot.
+   *
+   * @param id the id of the book.
+   * @return The revision of the last update of the book.
+   * @throw std::out_of_range if there is no such book in the snapshot.
+   */
+  Revision getLastUpdatedRevision(const std::string& id) const;
+
+  /**
+   * Get the number of books in the snapshot.
+   *
+   * @param localBooks If we must count local books (books with a path).
+   * @param remoteBooks If we must count remote books (books with an url)
+   * @return The number of books.
+   */
+  unsigned int getBookCount(const bool localBooks, const bool remoteBooks) const;
+
+  /**
+   * Get the ids of all books in the snapshot.
+   *
+   * @return A list of book ids (in increasing order).
+   */
+  BookIdCollection getBooksIds() const;
+
+  friend class Library;
+
+ private:
+  const Revision m_revision;
+  const EntryMap m_books;
+  const Facets m_facets;
+};
+
 // We don't need it anymore and we don't want to polute any other potential usage
 // of `LIBKIWIX_NODISCARD` token.
 #undef LIBKIWIX_NODISCARD
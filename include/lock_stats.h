@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_LOCK_STATS_H
+#define KIWIX_LOCK_STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kiwix
+{
+
+/**
+ * Contention statistics of a named lock.
+ *
+ * All instances of a lock share the same name (e.g. all `Library` objects
+ * report under "Library::m_mutex"). Nested acquisitions of a recursive lock
+ * by the thread already owning it are not counted.
+ */
+struct LockStatistics
+{
+  std::string name;
+
+  // Number of times the lock was acquired.
+  uint64_t acquisitions = 0;
+
+  // Number of acquisitions that had to wait for another owner.
+  uint64_t contentions = 0;
+
+  // Total and maximal time spent waiting for the lock (in nanoseconds).
+  uint64_t totalWaitNs = 0;
+  uint64_t maxWaitNs = 0;
+
+  // Total and maximal time the lock was held (in nanoseconds).
+  uint64_t totalHoldNs = 0;
+  uint64_t maxHoldNs = 0;
+};
+
+/**
+ * Tell if lock instrumentation is enabled.
+ *
+ * Lock instrumentation is disabled by default and is enabled by setting the
+ * environment variable KIWIX_LOCK_STATS to 1 before the process starts
+ * using libkiwix.
+ */
+bool isLockInstrumentationEnabled();
+
+/**
+ * Get the statistics of all named locks seen so far, sorted by name.
+ *
+ * Returns an empty vector if lock instrumentation is disabled.
+ */
+std::vector<LockStatistics> getLockStatistics();
+
+/**
+ * Reset the statistics of all named locks.
+ */
+void resetLockStatistics();
+
+}
+
+#endif // KIWIX_LOCK_STATS_H
@@ -34,6 +34,8 @@ class xml_document;
 namespace kiwix
 {
 
+class ZimMetadataCache;
+
 class LibraryManipulator
 {
  public: // functions
@@ -43,6 +45,7 @@ class LibraryManipulator
   LibraryPtr getLibrary() const { return library; }
 
   bool addBookToLibrary(const Book& book);
+  size_t addBooksToLibrary(const std::vector<Book>& books);
   void addBookmarkToLibrary(const Bookmark& bookmark);
   uint32_t removeBooksNotUpdatedSince(Library::Revision rev);
 
@@ -89,6 +92,35 @@ class Manager
    */
   void reload(const Paths& paths);
 
+  /**
+   * Enable the snapshots of the `library.xml` files.
+   *
+   * When enabled, readFile() saves the books of a trusted library file
+   * in a binary snapshot next to it (`<path>.snapshot`). As long as the
+   * content of the library file doesn't change, its books are then read
+   * from the snapshot rather than parsed again. Snapshots are disabled by
+   * default.
+   *
+   * @param enabled Whether the snapshots are used.
+   */
+  void setLibrarySnapshotsEnabled(bool enabled) { m_librarySnapshotsEnabled = enabled; }
+
+  /**
+   * Use a persistent cache of the metadata of the ZIM files.
+   *
+   * The books read from ZIM files (by addBookFromPath(),
+   * addBooksFromDirectory() or when reading an untrusted library file)
+   * are saved in the cache, along with the size, modification time and
+   * inode of their ZIM file. As long as these don't change, the book is
+   * taken from the cache instead of being read from the ZIM file again.
+   * The cache file is updated at the end of the directory scans and of the
+   * reading of library files, and when the manager is destroyed.
+   *
+   * @param path The path of the cache file (an empty path disables the
+   *             cache).
+   */
+  void setZimMetadataCachePath(const std::string& path);
+
   /**
    * Load a library content store in the string.
    *
@@ -174,7 +206,15 @@ class Manager
  protected:
   kiwix::LibraryManipulator manipulator;
 
+  bool m_librarySnapshotsEnabled = false;
+  std::shared_ptr<ZimMetadataCache> mp_zimMetadataCache;
+
   bool readBookFromPath(const std::string& path, Book* book);
+  std::vector<Book> readBooksFromXmlDom(const pugi::xml_document& doc,
+                                        bool readOnly,
+                                        const std::string& libraryPath,
+                                        bool trustLibrary);
+  bool readFileUsingSnapshot(const std::string& path, bool readOnly);
   bool parseXmlDom(const pugi::xml_document& doc,
                    bool readOnly,
                    const std::string& libraryPath,
@@ -84,6 +84,14 @@ namespace kiwix
        void setCatalogOnlyMode(bool enable) { m_catalogOnlyMode = enable; }
        void setContentServerUrl(std::string url) { m_contentServerUrl = url; }
 
+       /**
+        * Set the number of entries from which OPDS acquisition feeds are
+        * streamed instead of being built in memory before being sent.
+        *
+        * A negative value disables streaming. The default is 500.
+        */
+       void setOPDSStreamingThreshold(int threshold) { m_opdsStreamingThreshold = threshold; }
+
        /**
         * Listen for incoming connections on all IP addresses of the specified
         * IP protocol family.
@@ -146,6 +154,7 @@ namespace kiwix
        int m_ipConnectionLimit = 0;
        bool m_catalogOnlyMode = false;
        std::string m_contentServerUrl;
+       int m_opdsStreamingThreshold = 500;
        std::unique_ptr<InternalServer> mp_server;
   };
 }
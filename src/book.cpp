@@ -27,18 +27,134 @@
 #include "tools/stringTools.h"
 #include "tools/pathTools.h"
 #include "tools/archiveTools.h"
+#include "tools/binaryTools.h"
 
 #include <zim/archive.h>
 #include <zim/item.h>
 #include <pugixml.hpp>
 
+#include <unordered_map>
+
 namespace kiwix
 {
+
+namespace
+{
+
+// A set of interned values of an attribute of the books, indexed by their
+// string form. The pool doesn't own the values, so they are freed as soon
+// as no book uses them.
+template<class T>
+class InternPool
+{
+  public:
+    template<class F>
+    std::shared_ptr<const T> get(const std::string& key, F makeValue)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto& weakValue = m_values[key];
+      auto value = weakValue.lock();
+      if ( !value ) {
+        value = std::make_shared<const T>(makeValue(key));
+        weakValue = value;
+        // The cost of removing the expired values is amortized over
+        // as many insertions as there are values
+        if ( ++m_insertionCount >= m_values.size() ) {
+          removeExpiredValues();
+          m_insertionCount = 0;
+        }
+      }
+      return value;
+    }
+
+  private:
+    void removeExpiredValues()
+    {
+      for ( auto it = m_values.begin(); it != m_values.end(); ) {
+        it = it->second.expired() ? m_values.erase(it) : std::next(it);
+      }
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::weak_ptr<const T>> m_values;
+    size_t m_insertionCount = 0;
+};
+
+template<class T, class F>
+std::shared_ptr<const T> intern(const std::string& key, F makeValue)
+{
+  static InternPool<T> pool;
+  return pool.get(key, makeValue);
+}
+
+std::shared_ptr<const std::string> internString(const std::string& value)
+{
+  return intern<std::string>(value, [](const std::string& s) { return s; });
+}
+
+} // unnamed namespace
+
 /* Constructor */
 Book::Book() :
   m_pathValid(false),
   m_readOnly(false)
 {
+  // The empty values are never freed
+  static const auto emptyString = internString("");
+  static const auto emptyLanguages = intern<Languages>("", parseLanguages);
+  static const auto emptyTags = intern<Tags>("", parseTags);
+  m_category = m_creator = m_publisher = m_flavour = emptyString;
+  m_languages = emptyLanguages;
+  m_tags = emptyTags;
+}
+
+Book::Languages Book::parseLanguages(const std::string& languages)
+{
+  return Languages{languages, kiwix::split(languages, ",")};
+}
+
+Book::Tags Book::parseTags(const std::string& tags)
+{
+  Tags t{tags, {}};
+  for ( const auto& tag : convertTags(tags) ) {
+    const auto delimPos = tag.find(':');
+    if ( tag[0] == '_' && delimPos != std::string::npos ) {
+      // Like getTagValueFromTagList(), the first occurrence wins
+      t.values.emplace(tag.substr(1, delimPos-1), tag.substr(delimPos+1));
+    }
+  }
+  return t;
+}
+
+void Book::setLanguage(const std::string& language)
+{
+  m_languages = intern<Languages>(language, parseLanguages);
+}
+
+void Book::setCreator(const std::string& creator)
+{
+  m_creator = internString(creator);
+}
+
+void Book::setPublisher(const std::string& publisher)
+{
+  m_publisher = internString(publisher);
+}
+
+void Book::setFlavour(const std::string& flavour)
+{
+  m_flavour = internString(flavour);
+}
+
+void Book::setCategory(const std::string& category)
+{
+  m_category = internString(category);
+}
+
+void Book::setTags(const std::string& tags)
+{
+  m_tags = intern<Tags>(tags, parseTags);
 }
 
 /* Destructor */
@@ -69,14 +185,14 @@ void Book::update(const zim::Archive& archive) {
   m_id = std::string(archive.getUuid());
   m_title = getArchiveTitle(archive);
   m_description = getMetaDescription(archive);
-  m_language = getMetaLanguage(archive);
-  m_creator = getMetaCreator(archive);
-  m_publisher = getMetaPublisher(archive);
+  setLanguage(getMetaLanguage(archive));
+  setCreator(getMetaCreator(archive));
+  setPublisher(getMetaPublisher(archive));
   m_date = getMetaDate(archive);
   m_name = getMetaName(archive);
-  m_flavour = getMetaFlavour(archive);
-  m_tags = getMetaTags(archive);
-  m_category = getCategoryFromTags();
+  setFlavour(getMetaFlavour(archive));
+  setTags(getMetaTags(archive));
+  setCategory(getCategoryFromTags());
   m_articleCount = archive.getArticleCount();
   m_mediaCount = archive.getMediaCount();
   m_size = static_cast<uint64_t>(getArchiveFileSize(archive)) << 10;
@@ -106,14 +222,14 @@ void Book::updateFromXml(const pugi::xml_node& node, const std::string& baseDir)
   m_pathValid = fileReadable(path);
   m_title = ATTR("title");
   m_description = ATTR("description");
-  m_language = ATTR("language");
-  m_creator = ATTR("creator");
-  m_publisher = ATTR("publisher");
+  setLanguage(ATTR("language"));
+  setCreator(ATTR("creator"));
+  setPublisher(ATTR("publisher"));
   m_date = ATTR("date");
   m_url = ATTR("url");
   m_name = ATTR("name");
-  m_flavour = ATTR("flavour");
-  m_tags = ATTR("tags");
+  setFlavour(ATTR("flavour"));
+  setTags(ATTR("tags"));
   m_origId = ATTR("origId");
   m_articleCount = strtoull(ATTR("articleCount"), 0, 0);
   m_mediaCount = strtoull(ATTR("mediaCount"), 0, 0);
@@ -131,7 +247,7 @@ void Book::updateFromXml(const pugi::xml_node& node, const std::string& baseDir)
     m_downloadId = ATTR("downloadId");
   } catch(...) {}
   const auto catattr = node.attribute("category");
-  m_category = catattr.empty() ? getCategoryFromTags() : catattr.value();
+  setCategory(catattr.empty() ? getCategoryFromTags() : catattr.value());
 }
 #undef ATTR
 
@@ -154,17 +270,17 @@ void Book::updateFromOpds(const pugi::xml_node& node, const std::string& urlHost
   // No path on opds.
   m_title = VALUE("title");
   m_description = VALUE("summary");
-  m_language = VALUE("language");
-  m_creator = node.child("author").child("name").child_value();
-  m_publisher = node.child("publisher").child("name").child_value();
+  setLanguage(VALUE("language"));
+  setCreator(node.child("author").child("name").child_value());
+  setPublisher(node.child("publisher").child("name").child_value());
   const std::string dcIssuedDate = VALUE("dc:issued");
   m_date = dcIssuedDate.empty() ? VALUE("updated") : dcIssuedDate;
   m_date = fromOpdsDate(m_date);
   m_name = VALUE("name");
-  m_flavour = VALUE("flavour");
-  m_tags = VALUE("tags");
+  setFlavour(VALUE("flavour"));
+  setTags(VALUE("tags"));
   const auto catnode = node.child("category");
-  m_category = catnode.empty() ? getCategoryFromTags() : catnode.child_value();
+  setCategory(catnode.empty() ? getCategoryFromTags() : catnode.child_value());
   m_articleCount = strtoull(VALUE("articleCount"), 0, 0);
   m_mediaCount = strtoull(VALUE("mediaCount"), 0, 0);
   for(auto linkNode = node.child("link"); linkNode;
@@ -187,6 +303,73 @@ void Book::updateFromOpds(const pugi::xml_node& node, const std::string& urlHost
 }
 #undef VALUE
 
+void Book::updateFromBinary(BinaryReader& reader)
+{
+  m_id = reader.readString();
+  m_downloadId = reader.readString();
+  m_path = reader.readString();
+  m_pathValid = reader.readBool();
+  m_title = reader.readString();
+  m_description = reader.readString();
+  setCategory(reader.readString());
+  setLanguage(reader.readString());
+  setCreator(reader.readString());
+  setPublisher(reader.readString());
+  m_date = reader.readString();
+  m_url = reader.readString();
+  m_name = reader.readString();
+  setFlavour(reader.readString());
+  setTags(reader.readString());
+  m_origId = reader.readString();
+  m_articleCount = reader.readInt();
+  m_mediaCount = reader.readInt();
+  m_size = reader.readInt();
+  m_illustrations.clear();
+  for ( auto n = reader.readInt(); n != 0; --n ) {
+    const auto illustration = std::make_shared<Illustration>();
+    illustration->width = static_cast<uint16_t>(reader.readInt());
+    illustration->height = static_cast<uint16_t>(reader.readInt());
+    illustration->mimeType = reader.readString();
+    illustration->url = reader.readString();
+    illustration->data = reader.readString();
+    m_illustrations.push_back(illustration);
+  }
+}
+
+void Book::writeBinary(BinaryWriter& writer) const
+{
+  writer.writeString(m_id);
+  writer.writeString(m_downloadId);
+  writer.writeString(m_path);
+  writer.writeBool(m_pathValid);
+  writer.writeString(m_title);
+  writer.writeString(m_description);
+  writer.writeString(getCategory());
+  writer.writeString(getCommaSeparatedLanguages());
+  writer.writeString(getCreator());
+  writer.writeString(getPublisher());
+  writer.writeString(m_date);
+  writer.writeString(m_url);
+  writer.writeString(m_name);
+  writer.writeString(getFlavour());
+  writer.writeString(getTags());
+  writer.writeString(m_origId);
+  writer.writeInt(m_articleCount);
+  writer.writeInt(m_mediaCount);
+  writer.writeInt(m_size);
+  writer.writeInt(m_illustrations.size());
+  for ( const auto& illustration : m_illustrations ) {
+    writer.writeInt(illustration->width);
+    writer.writeInt(illustration->height);
+    writer.writeString(illustration->mimeType);
+    writer.writeString(illustration->url);
+    // The data of the illustrations that are downloaded on demand is
+    // written only if it was downloaded already
+    const std::lock_guard<std::mutex> l(illustration->mutex);
+    writer.writeString(illustration->data);
+  }
+}
+
 std::string Book::getHumanReadableIdFromPath() const
 {
   std::string id = m_path;
@@ -264,18 +447,17 @@ const std::string& Book::getFaviconMimeType() const
 }
 
 std::string Book::getTagStr(const std::string& tagName) const {
-  return getTagValueFromTagList(convertTags(m_tags), tagName);
+  const auto it = m_tags->values.find(tagName);
+  if ( it == m_tags->values.end() ) {
+    throw std::out_of_range(tagName + " cannot be found");
+  }
+  return it->second;
 }
 
 bool Book::getTagBool(const std::string& tagName) const {
   return convertStrToBool(getTagStr(tagName));
 }
 
-std::string Book::getCategory() const
-{
-  return m_category;
-}
-
 std::string Book::getCategoryFromTags() const
 {
   try
@@ -288,9 +470,4 @@ std::string Book::getCategoryFromTags() const
   }
 }
 
-const std::vector<std::string> Book::getLanguages() const
-{
-  return kiwix::split(m_language, ",");
-}
-
 }
@@ -66,10 +66,13 @@ kainjow::mustache::list getTagList(std::string tags)
 
 } // unnamed namespace
 
-std::string HTMLDumper::dumpPlainHTML(kiwix::Filter filter) const
+std::string HTMLDumper::dumpPlainHTML(kiwix::Filter filter,
+                                      supportedListSortBy sortBy,
+                                      bool ascending) const
 {
   kainjow::mustache::list booksData;
-  const auto filteredBooks = library->filter(filter);
+  auto filteredBooks = library->filter(filter);
+  library->sort(filteredBooks, sortBy, ascending);
   const auto searchQuery = filter.getQuery();
   auto languages = getLanguageData();
   auto categories = getCategoryData();
@@ -88,8 +91,10 @@ std::string HTMLDumper::dumpPlainHTML(kiwix::Filter filter) const
     }
   }
 
+  const auto snapshot = library->getSnapshot();
   for ( const auto& bookId : filteredBooks ) {
-    const auto bookObj = library->getBookById(bookId);
+    throwIfCancelled();
+    const Book& bookObj = snapshot->getBookById(bookId);
     const auto bookTitle = bookObj.getTitle();
     std::string contentId = "";
     try {
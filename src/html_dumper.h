@@ -40,9 +40,14 @@ class HTMLDumper : public LibraryDumper
   /**
    * Dump library in HTML
    *
+   * @param filter the filter selecting the books to dump
+   * @param sortBy the order of the books (UNSORTED keeps the filter order)
+   * @param ascending whether the order is ascending or descending
    * @return HTML content
    */
-  std::string dumpPlainHTML(kiwix::Filter filter) const;
+  std::string dumpPlainHTML(kiwix::Filter filter,
+                            supportedListSortBy sortBy = UNSORTED,
+                            bool ascending = true) const;
 };
 
 }
@@ -0,0 +1,261 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "json_dumper.h"
+#include "book.h"
+
+#include "tools/stringTools.h"
+#include "tools/otherTools.h"
+#include "tools.h"
+
+#include <stdexcept>
+
+namespace kiwix
+{
+
+/* Constructor */
+JSONDumper::JSONDumper(const Library* library, const NameMapper* nameMapper)
+  : LibraryDumper(library, nameMapper)
+{
+}
+/* Destructor */
+JSONDumper::~JSONDumper()
+{
+}
+
+namespace
+{
+
+// Rough size of a dumped book used to preallocate the output buffer
+const size_t BOOK_SIZE_ESTIMATE = 768;
+
+// Appends compact JSON to a string buffer, inserting the separators
+// between the elements of arrays and the members of objects.
+class JSONWriter
+{
+  public:
+    explicit JSONWriter(std::string& out) : m_out(out) {}
+
+    void beginObject() { beginValue(); m_out += '{'; m_needsComma.push_back(false); }
+    void endObject()   { m_needsComma.pop_back(); m_out += '}'; }
+    void beginArray()  { beginValue(); m_out += '['; m_needsComma.push_back(false); }
+    void endArray()    { m_needsComma.pop_back(); m_out += ']'; }
+
+    // Starts a member of the current object. Must be followed by its value.
+    JSONWriter& key(const char* name)
+    {
+      beginValue();
+      m_out += '"';
+      m_out += name;
+      m_out += "\":";
+      m_afterKey = true;
+      return *this;
+    }
+
+    void value(const std::string& s)
+    {
+      beginValue();
+      m_out += '"';
+      for ( const char c : s ) {
+        switch ( c ) {
+          case '"':  m_out += "\\\""; break;
+          case '\\': m_out += "\\\\"; break;
+          case '\n': m_out += "\\n";  break;
+          case '\r': m_out += "\\r";  break;
+          case '\t': m_out += "\\t";  break;
+          default:
+            if ( static_cast<unsigned char>(c) < 0x20 ) {
+              const char hexDigits[] = "0123456789abcdef";
+              m_out += "\\u00";
+              m_out += hexDigits[(c >> 4) & 0xf];
+              m_out += hexDigits[c & 0xf];
+            } else {
+              m_out += c;
+            }
+        }
+      }
+      m_out += '"';
+    }
+
+    void value(uint64_t n)
+    {
+      beginValue();
+      m_out += to_string(n);
+    }
+
+    void member(const char* name, const std::string& s) { key(name).value(s); }
+    void member(const char* name, uint64_t n)           { key(name).value(n); }
+
+  private:
+    void beginValue()
+    {
+      if ( m_afterKey ) {
+        m_afterKey = false;
+      } else if ( !m_needsComma.empty() ) {
+        if ( m_needsComma.back() ) {
+          m_out += ',';
+        }
+        m_needsComma.back() = true;
+      }
+    }
+
+  private:
+    std::string& m_out;
+    std::vector<bool> m_needsComma;
+    bool m_afterKey = false;
+};
+
+void writeBook(JSONWriter& w,
+               const Book& book,
+               const std::string& rootLocation,
+               const std::string& contentAccessUrl,
+               const std::string& contentId)
+{
+  w.beginObject();
+  w.member("id", book.getId());
+  w.member("name", book.getName());
+  w.member("title", book.getTitle());
+  w.member("description", book.getDescription());
+  w.key("languages").beginArray();
+  for ( const auto& lang : book.getLanguages() ) {
+    w.value(lang);
+  }
+  w.endArray();
+  w.member("category", book.getCategory());
+  w.member("flavour", book.getFlavour());
+  w.member("tags", book.getTags());
+  w.member("articleCount", book.getArticleCount());
+  w.member("mediaCount", book.getMediaCount());
+  w.member("size", book.getSize());
+  w.member("date", book.getDate());
+  w.member("creator", book.getCreator());
+  w.member("publisher", book.getPublisher());
+  w.key("illustrations").beginArray();
+  for ( const auto& illustration : book.getIllustrations() ) {
+    const auto size = to_string(illustration->width);
+    w.beginObject();
+    w.member("width", illustration->width);
+    w.member("height", illustration->height);
+    w.member("mimeType", illustration->mimeType);
+    w.member("url", rootLocation + "/catalog/v2/illustration/" + book.getId() + "/?size=" + size);
+    w.endObject();
+  }
+  w.endArray();
+  if ( !contentAccessUrl.empty() ) {
+    w.member("contentUrl", contentAccessUrl + "/" + urlEncode(contentId));
+  }
+  if ( !book.getUrl().empty() ) {
+    w.member("downloadUrl", book.getUrl());
+  }
+  w.endObject();
+}
+
+void writePartialBook(JSONWriter& w, const Book& book)
+{
+  w.beginObject();
+  w.member("id", book.getId());
+  w.member("title", book.getTitle());
+  w.member("date", book.getDate());
+  w.endObject();
+}
+
+} // unnamed namespace
+
+std::string JSONDumper::dumpEntries(const std::vector<std::string>& bookIds, bool partial) const
+{
+  std::string json;
+  json.reserve(128 + bookIds.size() * BOOK_SIZE_ESTIMATE);
+  JSONWriter w(json);
+  w.beginObject();
+  w.member("totalResults", m_totalResults);
+  w.member("startIndex", m_startIndex);
+  w.member("itemsPerPage", m_count);
+  if ( !m_nextCursor.empty() ) {
+    w.member("nextCursor", m_nextCursor);
+  }
+  w.key("entries").beginArray();
+  const auto snapshot = library->getSnapshot();
+  for ( const auto& bookId : bookIds ) {
+    throwIfCancelled();
+    try {
+      const Book& book = snapshot->getBookById(bookId);
+      if ( partial ) {
+        writePartialBook(w, book);
+      } else {
+        const std::string contentId = nameMapper->getNameForId(bookId);
+        writeBook(w, book, rootLocation, contentAccessUrl, contentId);
+      }
+    } catch ( const std::out_of_range& ) {
+      // the book was removed from the library since its id was obtained
+      // ignore it
+    }
+  }
+  w.endArray();
+  w.endObject();
+  json += '\n';
+  return json;
+}
+
+std::string JSONDumper::dumpEntry(const std::string& bookId) const
+{
+  const auto book = library->getBookPtrById(bookId);
+  const std::string contentId = nameMapper->getNameForId(bookId);
+  std::string json;
+  json.reserve(BOOK_SIZE_ESTIMATE);
+  JSONWriter w(json);
+  writeBook(w, *book, rootLocation, contentAccessUrl, contentId);
+  json += '\n';
+  return json;
+}
+
+std::string JSONDumper::dumpCategories() const
+{
+  std::string json;
+  JSONWriter w(json);
+  w.beginObject();
+  w.key("categories").beginArray();
+  for ( const auto& category : library->getBooksCategories() ) {
+    w.value(category);
+  }
+  w.endArray();
+  w.endObject();
+  json += '\n';
+  return json;
+}
+
+std::string JSONDumper::dumpLanguages() const
+{
+  std::string json;
+  JSONWriter w(json);
+  w.beginObject();
+  w.key("languages").beginArray();
+  for ( const auto& langAndBookCount : library->getBooksLanguagesWithCounts() ) {
+    w.beginObject();
+    w.member("code", langAndBookCount.first);
+    w.member("selfName", getLanguageSelfName(langAndBookCount.first));
+    w.member("bookCount", langAndBookCount.second);
+    w.endObject();
+  }
+  w.endArray();
+  w.endObject();
+  json += '\n';
+  return json;
+}
+
+} // namespace kiwix
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_JSON_DUMPER_H
+#define KIWIX_JSON_DUMPER_H
+
+#include <string>
+#include <vector>
+
+#include "library_dumper.h"
+
+namespace kiwix
+{
+
+/**
+ * A tool to dump a `Library` in JSON format.
+ *
+ * The JSON documents carry the same information as the respective OPDS
+ * feeds, without the Atom/OPDS boilerplate.
+ */
+class JSONDumper : public LibraryDumper
+{
+ public:
+  JSONDumper(const Library* library, const NameMapper* NameMapper);
+  ~JSONDumper();
+
+  /**
+   * Dump a list of books.
+   *
+   * @param bookIds the ids of the books to dump
+   * @param partial whether to dump only the id, title and date of the books
+   * @return A JSON object with the search info (including the cursor to
+   *         the next page, if any) and the list of books.
+   */
+  std::string dumpEntries(const std::vector<std::string>& bookIds, bool partial) const;
+
+  /**
+   * Dump a single book.
+   *
+   * @param bookId the id of the book
+   * @return A JSON object describing the book.
+   */
+  std::string dumpEntry(const std::string& bookId) const;
+
+  /**
+   * Dump the categories of the books in the library.
+   *
+   * @return A JSON object with the list of categories.
+   */
+  std::string dumpCategories() const;
+
+  /**
+   * Dump the languages of the books in the library.
+   *
+   * @return A JSON object with the list of languages and their book counts.
+   */
+  std::string dumpLanguages() const;
+};
+
+}
+
+#endif // KIWIX_JSON_DUMPER_H
@@ -28,11 +28,16 @@
 #include "tools/stringTools.h"
 #include "tools/otherTools.h"
 #include "tools/concurrent_cache.h"
+#include "tools/tracepoints.h"
+#include "tools/instrumented_lock.h"
 
 #include <pugixml.hpp>
 #include <algorithm>
+#include <functional>
+#include <numeric>
 #include <set>
 #include <cmath>
+#include <stdexcept>
 #include <unicode/locid.h>
 #include <xapian.h>
 
@@ -53,6 +58,92 @@ std::string normalizeText(const std::string& text)
   return removeAccents(text);
 }
 
+// Value slots of the documents of the book DB
+enum BookDBValueSlot : Xapian::valueno
+{
+  SIZE_SLOT,
+  DATE_SLOT,
+  ARTICLE_COUNT_SLOT,
+  MEDIA_COUNT_SLOT
+};
+
+// Builds the documents of the book DB. A single builder may be used for
+// many books, so that the term generator and the stemmers are reused.
+class BookDocumentBuilder
+{
+  public:
+    Xapian::Document build(const Book& book)
+    {
+      Xapian::Document doc;
+      m_indexer.set_document(doc);
+      m_indexer.set_stemmer(getStemmer(book));
+      m_indexer.set_stemming_strategy(Xapian::TermGenerator::STEM_SOME);
+
+      const std::string title = normalizeText(book.getTitle());
+      const std::string desc = normalizeText(book.getDescription());
+
+      // Index title and description without prefixes for general search
+      m_indexer.index_text(title);
+      m_indexer.increase_termpos();
+      m_indexer.index_text(desc);
+
+      // Index all fields for field-based search
+      m_indexer.index_text(title, 1, "S");
+      m_indexer.index_text(desc,  1, "XD");
+      for ( const auto& lang : book.getLanguages() ) {
+        m_indexer.index_text(lang,  1, "L");
+      }
+      m_indexer.index_text(normalizeText(book.getCreator()),   1, "A");
+      m_indexer.index_text(normalizeText(book.getPublisher()), 1, "XP");
+      doc.add_term("XN"+normalizeText(book.getName()));
+      m_indexer.index_text(normalizeText(book.getFlavour()),  1, "XF");
+      m_indexer.index_text(normalizeText(book.getCategory()),  1, "XC");
+
+      for ( const auto& tag : split(normalizeText(book.getTags()), ";") ) {
+        doc.add_boolean_term("XT" + tag);
+        if ( tag[0] != '_' ) {
+          m_indexer.increase_termpos();
+          m_indexer.index_text(tag);
+        }
+      }
+
+      doc.add_value(SIZE_SLOT, Xapian::sortable_serialise(book.getSize()));
+      doc.add_value(DATE_SLOT, book.getDate());
+      doc.add_value(ARTICLE_COUNT_SLOT, Xapian::sortable_serialise(book.getArticleCount()));
+      doc.add_value(MEDIA_COUNT_SLOT, Xapian::sortable_serialise(book.getMediaCount()));
+
+      doc.add_boolean_term("Q" + book.getId());
+
+      doc.set_data(book.getId());
+      return doc;
+    }
+
+  private:
+    // Books are stemmed only if they are in a single language
+    // (supported by Xapian)
+    Xapian::Stem getStemmer(const Book& book)
+    {
+      const auto& langs = book.getLanguages();
+      if ( langs.size() != 1 ) {
+        return Xapian::Stem();
+      }
+      const auto it = m_stemmers.find(langs[0]);
+      if ( it != m_stemmers.end() ) {
+        return it->second;
+      }
+      Xapian::Stem stemmer;
+      try {
+        stemmer = Xapian::Stem(iso639_3ToXapian(langs[0]));
+      } catch (...) {}
+      m_stemmers[langs[0]] = stemmer;
+      return stemmer;
+    }
+
+  private:
+    Xapian::TermGenerator m_indexer;
+    std::map<std::string, Xapian::Stem> m_stemmers;
+};
+
 bool booksReferToTheSameArchive(const Book& book1, const Book& book2)
 {
   return book1.isPathValid()
@@ -60,19 +151,36 @@ bool booksReferToTheSameArchive(const Book& book1, const Book& book2)
       && book1.getPath() == book2.getPath();
 }
 
+class LibraryLock : public InstrumentedLock<std::recursive_mutex>
+{
+  public:
+    explicit LibraryLock(std::recursive_mutex& mutex)
+      : InstrumentedLock(mutex, counters())
+    {}
+
+  private:
+    static LockCounters& counters()
+    {
+      static LockCounters& c = getLockCounters("Library::m_mutex");
+      return c;
+    }
+};
+
+const int DEFAULT_FILTER_CACHE_SIZE = 100;
+
 } // unnamed namespace
 
 template<typename Key, typename Value>
 class MultiKeyCache: public ConcurrentCache<std::set<Key>, Value>
 {
   public:
-    explicit MultiKeyCache(size_t maxEntries)
-      : ConcurrentCache<std::set<Key>, Value>(maxEntries)
+    MultiKeyCache(size_t maxEntries, const std::string& lockName)
+      : ConcurrentCache<std::set<Key>, Value>(maxEntries, lockName)
     {}
 
     bool drop(const Key& key)
     {
-      std::unique_lock<std::mutex> l(this->lock_);
+      typename MultiKeyCache::Lock l(this->lock_, this->lockCounters_);
       bool removed = false;
       for(auto& cache_key: this->impl_.keys()) {
         if(cache_key.find(key)!=cache_key.end()) {
@@ -83,26 +191,70 @@ class MultiKeyCache: public ConcurrentCache<std::set<Key>, Value>
     }
 };
 
-unsigned int
-Library::getBookCount_not_protected(const bool localBooks, const bool remoteBooks) const
+namespace
 {
-  unsigned int result = 0;
-  for (auto& pair: m_books) {
-    auto& book = pair.second;
-    if ((!book.getPath().empty() && localBooks)
-        || (!book.getUrl().empty() && remoteBooks)) {
-      result++;
+
+void updateCount(Library::AttributeCounts& counts, const std::string& key, int delta)
+{
+  auto& count = counts[key];
+  count += delta;
+  if ( count <= 0 ) {
+    counts.erase(key);
+  }
+}
+
+std::vector<std::string> getKeys(const Library::AttributeCounts& counts)
+{
+  std::vector<std::string> keys;
+  keys.reserve(counts.size());
+  for ( const auto& kv : counts ) {
+    keys.push_back(kv.first);
+  }
+  return keys;
+}
+
+} // unnamed namespace
+
+void Library::Facets::update(const Book& book, int delta)
+{
+  const bool local = !book.getPath().empty();
+  const bool remote = !book.getUrl().empty();
+  localBookCount += local ? delta : 0;
+  remoteBookCount += remote ? delta : 0;
+  localOrRemoteBookCount += (local || remote) ? delta : 0;
+
+  if ( !book.getCategory().empty() ) {
+    updateCount(categories, book.getCategory(), delta);
+  }
+  if ( book.getOrigId().empty() ) {
+    for ( const auto& lang : book.getLanguages() ) {
+      updateCount(languages, lang, delta);
     }
+    updateCount(creators, book.getCreator(), delta);
+    updateCount(publishers, book.getPublisher(), delta);
   }
-  return result;
+}
+
+unsigned int Library::Facets::getBookCount(const bool localBooks, const bool remoteBooks) const
+{
+  if ( localBooks && remoteBooks ) {
+    return localOrRemoteBookCount;
+  }
+  return localBooks ? localBookCount : (remoteBooks ? remoteBookCount : 0);
 }
 
 /* Constructor */
 Library::Library()
-  : mp_archiveCache(new ArchiveCache(std::max(getEnvVar<int>("KIWIX_ARCHIVE_CACHE_SIZE", 1), 1))),
-    mp_searcherCache(new SearcherCache(std::max(getEnvVar<int>("KIWIX_SEARCHER_CACHE_SIZE", 1), 1))),
+  : m_revision(0),
+    mp_archiveCache(new ArchiveCache(std::max(getEnvVar<int>("KIWIX_ARCHIVE_CACHE_SIZE", 1), 1),
+                                     "Library::mp_archiveCache")),
+    mp_searcherCache(new SearcherCache(std::max(getEnvVar<int>("KIWIX_SEARCHER_CACHE_SIZE", 1), 1),
+                                       "Library::mp_searcherCache")),
+    mp_filterCache(new FilterCache(std::max(getEnvVar<int>("KIWIX_FILTER_CACHE_SIZE", DEFAULT_FILTER_CACHE_SIZE), 1),
+                                   "Library::mp_filterCache")),
     m_bookDB(new Xapian::WritableDatabase("", Xapian::DB_BACKEND_INMEMORY))
 {
+  publishSnapshot();
 }
 
 /* Destructor */
@@ -110,44 +262,104 @@ Library::~Library() = default;
 
 bool Library::addBook(const Book& book)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  const auto titleSortKey = getCollationKey(book.getTitle());
+  LibraryLock lock(m_mutex);
   ++m_revision;
-  /* Try to find it */
-  updateBookDB(book);
-  try {
-    auto& oldbook = m_books.at(book.getId());
-    if ( ! booksReferToTheSameArchive(oldbook, book) ) {
+  BookDocumentBuilder documentBuilder;
+  m_bookDB->replace_document("Q" + book.getId(), documentBuilder.build(book));
+  const bool bookWasAdded = addOrUpdateEntry(book, titleSortKey);
+  if ( bookWasAdded ) {
+    updateCacheSizes();
+  }
+  publishSnapshot();
+  return bookWasAdded;
+}
+
+Library::BookIdCollection Library::addBooks(const std::vector<Book>& books)
+{
+  if ( books.empty() ) {
+    return BookIdCollection();
+  }
+
+  std::vector<std::string> titleSortKeys;
+  titleSortKeys.reserve(books.size());
+  for ( const auto& book : books ) {
+    titleSortKeys.push_back(getCollationKey(book.getTitle()));
+  }
+
+  BookIdCollection addedBookIds;
+  LibraryLock lock(m_mutex);
+  ++m_revision;
+  BookDocumentBuilder documentBuilder;
+  for ( size_t i = 0; i < books.size(); ++i ) {
+    const auto& book = books[i];
+    m_bookDB->replace_document("Q" + book.getId(), documentBuilder.build(book));
+    if ( addOrUpdateEntry(book, titleSortKeys[i]) ) {
+      addedBookIds.push_back(book.getId());
+    }
+  }
+  if ( !addedBookIds.empty() ) {
+    updateCacheSizes();
+  }
+  publishSnapshot();
+  return addedBookIds;
+}
+
+bool Library::addOrUpdateEntry(const Book& book, const std::string& titleSortKey)
+{
+  const auto it = m_books.find(book.getId());
+  if ( it != m_books.end() ) {
+    // The old entry may be shared with snapshots, so it is replaced
+    // rather than modified
+    const auto oldbook = std::make_shared<Entry>(*it->second);
+    if ( ! booksReferToTheSameArchive(*oldbook, book) ) {
       dropCache(book.getId());
     }
-    oldbook.update(book); // XXX: This may have no effect if oldbook is readonly
-                          // XXX: Then m_bookDB will become out-of-sync with
-                          // XXX: the real contents of the library.
-    oldbook.lastUpdatedRevision = m_revision;
+    oldbook->update(book); // XXX: This may have no effect if oldbook is readonly
+                           // XXX: Then m_bookDB will become out-of-sync with
+                           // XXX: the real contents of the library.
+    oldbook->lastUpdatedRevision = m_revision;
+    oldbook->titleSortKey = oldbook->getTitle() == book.getTitle()
+                          ? titleSortKey
+                          : getCollationKey(oldbook->getTitle());
+    m_facets.remove(*it->second);
+    m_facets.add(*oldbook);
+    removeFromIndexes(*it->second);
+    addToIndexes(*oldbook);
+    it->second = oldbook;
     return false;
-  } catch (std::out_of_range&) {
-    auto& newEntry = m_books[book.getId()];
-    static_cast<Book&>(newEntry) = book;
-    newEntry.lastUpdatedRevision = m_revision;
-    size_t new_cache_size = static_cast<size_t>(std::ceil(getBookCount_not_protected(true, true)*0.1));
-    if (getEnvVar<int>("KIWIX_ARCHIVE_CACHE_SIZE", -1) <= 0) {
-      mp_archiveCache->setMaxSize(new_cache_size);
-    }
-    if (getEnvVar<int>("KIWIX_SEARCHER_CACHE_SIZE", -1) <= 0) {
-      mp_searcherCache->setMaxSize(new_cache_size);
-    }
+  } else {
+    const auto newEntry = std::make_shared<Entry>();
+    static_cast<Book&>(*newEntry) = book;
+    newEntry->lastUpdatedRevision = m_revision;
+    newEntry->titleSortKey = titleSortKey;
+    m_books[book.getId()] = newEntry;
+    m_facets.add(*newEntry);
+    addToIndexes(*newEntry);
     return true;
   }
 }
 
+void Library::updateCacheSizes()
+{
+  size_t new_cache_size = static_cast<size_t>(std::ceil(m_facets.getBookCount(true, true)*0.1));
+  if (getEnvVar<int>("KIWIX_ARCHIVE_CACHE_SIZE", -1) <= 0) {
+    mp_archiveCache->setMaxSize(new_cache_size);
+  }
+  if (getEnvVar<int>("KIWIX_SEARCHER_CACHE_SIZE", -1) <= 0) {
+    mp_searcherCache->setMaxSize(new_cache_size);
+  }
+}
+
 void Library::addBookmark(const Bookmark& bookmark)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  LibraryLock lock(m_mutex);
   m_bookmarks.push_back(bookmark);
 }
 
 bool Library::removeBookmark(const std::string& zimId, const std::string& url)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  LibraryLock lock(m_mutex);
   for(auto it=m_bookmarks.begin(); it!=m_bookmarks.end(); it++) {
     if (it->getBookId() == zimId && it->getUrl() == url) {
       m_bookmarks.erase(it);
@@ -161,7 +373,7 @@ std::tuple<int, int> Library::migrateBookmarks(MigrationMode migrationMode) {
   std::set<std::string> sourceBooks;
   int invalidBookmarks = 0;
   {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LibraryLock lock(m_mutex);
     for(auto& bookmark:m_bookmarks) {
       if (m_books.find(bookmark.getBookId()) == m_books.end()) {
         invalidBookmarks += 1;
@@ -247,11 +459,14 @@ std::string Library::getBestTargetBookId(const std::string& bookName, const std:
 }
 
 std::string Library::getBestTargetBookId(const Bookmark& bookmark, MigrationMode migrationMode) const {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  LibraryLock lock(m_mutex);
   // Search for a existing book with the same name
-  auto book_filter = Filter();
+  BookIdCollection targetBooks;
   if (!bookmark.getBookName().empty()) {
-    book_filter.name(bookmark.getBookName());
+    const auto it = m_bookIdsByName.find(normalizeText(bookmark.getBookName()));
+    if (it != m_bookIdsByName.end()) {
+      targetBooks.assign(it->second.begin(), it->second.end());
+    }
   } else {
     // We don't have a name stored (older bookmarks)
     // Fallback on title (All bookmarks should have one, but let's be safe against wrongly filled bookmark)
@@ -259,9 +474,10 @@ std::string Library::getBestTargetBookId(const Bookmark& bookmark, MigrationMode
         // No bookName nor bookTitle, no way to find target book.
         return "";
     }
+    auto book_filter = Filter();
     book_filter.query("title:\"" + remove_quote(bookmark.getBookTitle()) + "\"");
+    targetBooks = filter(book_filter);
   }
-  auto targetBooks = filter(book_filter);
   auto bestBook = getBestFromBookCollection(targetBooks, bookmark, migrationMode);
   if (bestBook.empty()) {
     try {
@@ -273,7 +489,7 @@ std::string Library::getBestTargetBookId(const Bookmark& bookmark, MigrationMode
 }
 
 int Library::migrateBookmarks(const std::string& sourceBookId, MigrationMode migrationMode) {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  LibraryLock lock(m_mutex);
 
   Bookmark firstBookmarkToChange;
   for(auto& bookmark:m_bookmarks) {
@@ -319,7 +535,33 @@ void Library::dropCache(const std::string& id)
 
 bool Library::removeBookById(const std::string& id)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  LibraryLock lock(m_mutex);
+  const bool bookWasRemoved = removeEntry(id);
+  if ( bookWasRemoved ) {
+    ++m_revision;
+    publishSnapshot();
+  }
+  return bookWasRemoved;
+}
+
+uint32_t Library::removeBooksByIds(const BookIdCollection& ids)
+{
+  LibraryLock lock(m_mutex);
+  uint32_t countOfRemovedBooks = 0;
+  for ( const auto& id : ids ) {
+    if ( removeEntry(id) ) {
+      ++countOfRemovedBooks;
+    }
+  }
+  if ( countOfRemovedBooks != 0 ) {
+    ++m_revision;
+    publishSnapshot();
+  }
+  return countOfRemovedBooks;
+}
+
+bool Library::removeEntry(const std::string& id)
+{
   m_bookDB->delete_document("Q" + id);
   dropCache(id);
   // We do not change the cache size here
@@ -328,60 +570,109 @@ bool Library::removeBookById(const std::string& id)
   // Having a too big cache is not a problem here (or it would have been before)
   // (And setMaxSize doesn't actually reduce the cache size, extra cached items
   //  will be removed in put or getOrPut).
-  const bool bookWasRemoved = m_books.erase(id) == 1;
-  if ( bookWasRemoved ) {
-    ++m_revision;
+  const auto it = m_books.find(id);
+  if ( it == m_books.end() ) {
+    return false;
   }
-  return bookWasRemoved;
+  m_facets.remove(*it->second);
+  removeFromIndexes(*it->second);
+  m_books.erase(it);
+  return true;
 }
 
 Library::Revision Library::getRevision() const
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
   return m_revision;
 }
 
+void Library::publishSnapshot()
+{
+  // Called under the lock by every function changing the books, so that
+  // the readers never have to take the lock in order to get a snapshot.
+  // Only the pointers to the entries are copied.
+  std::atomic_store(&mp_snapshot,
+                    std::make_shared<const Snapshot>(m_revision, m_books, m_facets));
+}
+
+Library::ConstSnapshotPtr Library::getSnapshot() const
+{
+  return std::atomic_load(&mp_snapshot);
+}
+
+Library::Snapshot::Snapshot(Revision revision, const EntryMap& books, const Facets& facets)
+  : m_revision(revision),
+    m_books(books),
+    m_facets(facets)
+{
+}
+
+const Book& Library::Snapshot::getBookById(const std::string& id) const
+{
+  return *m_books.at(id);
+}
+
+std::shared_ptr<const Book> Library::Snapshot::getBookPtrById(const std::string& id) const
+{
+  return m_books.at(id);
+}
+
+Library::Revision Library::Snapshot::getLastUpdatedRevision(const std::string& id) const
+{
+  return m_books.at(id)->lastUpdatedRevision;
+}
+
+unsigned int Library::Snapshot::getBookCount(const bool localBooks, const bool remoteBooks) const
+{
+  return m_facets.getBookCount(localBooks, remoteBooks);
+}
+
+Library::BookIdCollection Library::Snapshot::getBooksIds() const
+{
+  BookIdCollection bookIds;
+  bookIds.reserve(m_books.size());
+  for (auto& pair: m_books) {
+    bookIds.push_back(pair.first);
+  }
+  return bookIds;
+}
+
 uint32_t Library::removeBooksNotUpdatedSince(Revision libraryRevision)
 {
+  LibraryLock lock(m_mutex);
   BookIdCollection booksToRemove;
-  {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    for ( const auto& entry : m_books) {
-      if ( entry.second.lastUpdatedRevision <= libraryRevision ) {
-        booksToRemove.push_back(entry.first);
-      }
+  for ( const auto& entry : m_books) {
+    if ( entry.second->lastUpdatedRevision <= libraryRevision ) {
+      booksToRemove.push_back(entry.first);
     }
   }
-
-  uint32_t countOfRemovedBooks = 0;
-  for ( const auto& id : booksToRemove ) {
-    if ( removeBookById(id) )
-      ++countOfRemovedBooks;
-  }
-  return countOfRemovedBooks;
+  return removeBooksByIds(booksToRemove);
 }
 
 const Book& Library::getBookById(const std::string& id) const
 {
-  // XXX: Doesn't make sense to lock this operation since it cannot
-  // XXX: guarantee thread-safety because of its return type
-  return m_books.at(id);
+  // XXX: The returned book is kept alive only by the current snapshot,
+  // XXX: i.e. until the next change of the library (see the deprecation
+  // XXX: note in library.h)
+  return getSnapshot()->getBookById(id);
 }
 
 Book Library::getBookByIdThreadSafe(const std::string& id) const
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  return getBookById(id);
+  return getSnapshot()->getBookById(id);
+}
+
+std::shared_ptr<const Book> Library::getBookPtrById(const std::string& id) const
+{
+  return getSnapshot()->getBookPtrById(id);
 }
 
 const Book& Library::getBookByPath(const std::string& path) const
 {
   // XXX: Doesn't make sense to lock this operation since it cannot
   // XXX: guarantee thread-safety because of its return type
-  for(auto& it: m_books) {
-    auto& book = it.second;
-    if (book.getPath() == path)
-      return book;
+  const auto it = m_bookIdsByPath.find(path);
+  if (it != m_bookIdsByPath.end()) {
+    return *m_books.at(*it->second.begin());
   }
   std::ostringstream ss;
   ss << "No book with path " << path << " in the library." << std::endl;
@@ -393,11 +684,14 @@ std::shared_ptr<zim::Archive> Library::getArchiveById(const std::string& id)
   try {
     return mp_archiveCache->getOrPut(id,
     [&](){
-      auto book = getBookById(id);
-      if (!book.isPathValid()) {
+      const auto book = getBookPtrById(id);
+      if (!book->isPathValid()) {
         throw std::invalid_argument("");
       }
-      return std::make_shared<zim::Archive>(book.getPath());
+      KIWIX_TRACE1(archive_open_start, id.c_str());
+      auto archive = std::make_shared<zim::Archive>(book->getPath());
+      KIWIX_TRACE1(archive_open_end, id.c_str());
+      return archive;
     });
   } catch (std::invalid_argument&) {
     return nullptr;
@@ -428,8 +722,7 @@ std::shared_ptr<ZimSearcher> Library::getSearcherByIds(const BookIdSet& ids)
 unsigned int Library::getBookCount(const bool localBooks,
                                    const bool remoteBooks) const
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  return getBookCount_not_protected(localBooks, remoteBooks);
+  return getSnapshot()->getBookCount(localBooks, remoteBooks);
 }
 
 bool Library::writeToFile(const std::string& path) const
@@ -441,7 +734,7 @@ bool Library::writeToFile(const std::string& path) const
   dumper.setBaseDir(baseDir);
   std::string xml;
   {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    LibraryLock lock(m_mutex);
     xml = dumper.dumpLibXMLContent(allBookIds);
   };
   return writeTextFile(path, xml);
@@ -455,78 +748,29 @@ bool Library::writeBookmarksToFile(const std::string& path) const
   return writeTextFile(path, xml);
 }
 
-Library::AttributeCounts Library::getBookAttributeCounts(BookStrPropMemFn p) const
-{
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  AttributeCounts propValueCounts;
-
-  for (const auto& pair: m_books) {
-    const auto& book = pair.second;
-    if (book.getOrigId().empty()) {
-      propValueCounts[(book.*p)()] += 1;
-    }
-  }
-  return propValueCounts;
-}
-
-std::vector<std::string> Library::getBookPropValueSet(BookStrPropMemFn p) const
-{
-  std::vector<std::string> result;
-  for ( const auto& kv : getBookAttributeCounts(p) ) {
-    result.push_back(kv.first);
-  }
-  return result;
-}
-
 std::vector<std::string> Library::getBooksLanguages() const
 {
-  std::vector<std::string> langs;
-  for ( const auto& langAndCount : getBooksLanguagesWithCounts() ) {
-    langs.push_back(langAndCount.first);
-  }
-  return langs;
+  return getKeys(getSnapshot()->m_facets.languages);
 }
 
 Library::AttributeCounts Library::getBooksLanguagesWithCounts() const
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  AttributeCounts langsWithCounts;
-
-  for (const auto& pair: m_books) {
-    const auto& book = pair.second;
-    if (book.getOrigId().empty()) {
-      for ( const auto& lang : book.getLanguages() ) {
-        ++langsWithCounts[lang];
-      }
-    }
-  }
-  return langsWithCounts;
+  return getSnapshot()->m_facets.languages;
 }
 
 std::vector<std::string> Library::getBooksCategories() const
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  std::set<std::string> categories;
-
-  for (const auto& pair: m_books) {
-    const auto& book = pair.second;
-    const auto& c = book.getCategory();
-    if ( !c.empty() ) {
-      categories.insert(c);
-    }
-  }
-
-  return std::vector<std::string>(categories.begin(), categories.end());
+  return getKeys(getSnapshot()->m_facets.categories);
 }
 
 std::vector<std::string> Library::getBooksCreators() const
 {
-  return getBookPropValueSet(&Book::getCreator);
+  return getKeys(getSnapshot()->m_facets.creators);
 }
 
 std::vector<std::string> Library::getBooksPublishers() const
 {
-  return getBookPropValueSet(&Book::getPublisher);
+  return getKeys(getSnapshot()->m_facets.publishers);
 }
 
 const std::vector<kiwix::Bookmark> Library::getBookmarks(bool onlyValidBookmarks) const
@@ -536,7 +780,7 @@ const std::vector<kiwix::Bookmark> Library::getBookmarks(bool onlyValidBookmarks
   }
   std::vector<kiwix::Bookmark> validBookmarks;
   auto booksId = getBooksIds();
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  LibraryLock lock(m_mutex);
   for(auto& bookmark:m_bookmarks) {
     if (std::find(booksId.begin(), booksId.end(), bookmark.getBookId()) != booksId.end()) {
       validBookmarks.push_back(bookmark);
@@ -547,66 +791,47 @@ const std::vector<kiwix::Bookmark> Library::getBookmarks(bool onlyValidBookmarks
 
 Library::BookIdCollection Library::getBooksIds() const
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  BookIdCollection bookIds;
+  return getSnapshot()->getBooksIds();
+}
 
-  for (auto& pair: m_books) {
-    bookIds.push_back(pair.first);
-  }
 
-  return bookIds;
-}
+namespace
+{
 
+void addToIndex(std::unordered_map<std::string, Library::BookIdSet>& index,
+                const std::string& key, const std::string& bookId)
+{
+  if ( !key.empty() ) {
+    index[key].insert(bookId);
+  }
+}
 
-void Library::updateBookDB(const Book& book)
+void removeFromIndex(std::unordered_map<std::string, Library::BookIdSet>& index,
+                     const std::string& key, const std::string& bookId)
 {
-  Xapian::Stem stemmer;
-  Xapian::TermGenerator indexer;
-  const auto langs = book.getLanguages();
-  if ( langs.size() == 1 ) {
-    try {
-      stemmer = Xapian::Stem(iso639_3ToXapian(langs[0]));
-      indexer.set_stemmer(stemmer);
-      indexer.set_stemming_strategy(Xapian::TermGenerator::STEM_SOME);
-    } catch (...) {}
-  }
-  Xapian::Document doc;
-  indexer.set_document(doc);
-
-  const std::string title = normalizeText(book.getTitle());
-  const std::string desc = normalizeText(book.getDescription());
-
-  // Index title and description without prefixes for general search
-  indexer.index_text(title);
-  indexer.increase_termpos();
-  indexer.index_text(desc);
-
-  // Index all fields for field-based search
-  indexer.index_text(title, 1, "S");
-  indexer.index_text(desc,  1, "XD");
-  for ( const auto& lang : langs ) {
-    indexer.index_text(lang,  1, "L");
-  }
-  indexer.index_text(normalizeText(book.getCreator()),   1, "A");
-  indexer.index_text(normalizeText(book.getPublisher()), 1, "XP");
-  doc.add_term("XN"+normalizeText(book.getName()));
-  indexer.index_text(normalizeText(book.getFlavour()),  1, "XF");
-  indexer.index_text(normalizeText(book.getCategory()),  1, "XC");
-
-  for ( const auto& tag : split(normalizeText(book.getTags()), ";") ) {
-    doc.add_boolean_term("XT" + tag);
-    if ( tag[0] != '_' ) {
-      indexer.increase_termpos();
-      indexer.index_text(tag);
+  const auto it = index.find(key);
+  if ( it != index.end() ) {
+    it->second.erase(bookId);
+    if ( it->second.empty() ) {
+      index.erase(it);
     }
   }
+}
 
-  const std::string idterm = "Q" + book.getId();
-  doc.add_boolean_term(idterm);
+} // unnamed namespace
 
-  doc.set_data(book.getId());
+// Books are indexed by name the way the book DB does it, so that a name
+// is found in the index if and only if Filter::name() would match it
+void Library::addToIndexes(const Book& book)
+{
+  addToIndex(m_bookIdsByPath, book.getPath(), book.getId());
+  addToIndex(m_bookIdsByName, normalizeText(book.getName()), book.getId());
+}
 
-  m_bookDB->replace_document(idterm, doc);
+void Library::removeFromIndexes(const Book& book)
+{
+  removeFromIndex(m_bookIdsByPath, book.getPath(), book.getId());
+  removeFromIndex(m_bookIdsByName, normalizeText(book.getName()), book.getId());
 }
 
 namespace
@@ -747,24 +972,71 @@ Xapian::Query buildXapianQuery(const Filter& filter)
     const auto tq = tagsQuery(filter.getAcceptTags(), filter.getRejectTags());
     q = Xapian::Query(Xapian::Query::OP_AND, q, tq);;
   }
+  if ( filter.hasMinSize() ) {
+    const auto minSize = Xapian::sortable_serialise(filter.getMinSize());
+    q = Xapian::Query(Xapian::Query::OP_AND, q, Xapian::Query(Xapian::Query::OP_VALUE_GE, SIZE_SLOT, minSize));
+  }
+  if ( filter.hasMaxSize() ) {
+    const auto maxSize = Xapian::sortable_serialise(filter.getMaxSize());
+    q = Xapian::Query(Xapian::Query::OP_AND, q, Xapian::Query(Xapian::Query::OP_VALUE_LE, SIZE_SLOT, maxSize));
+  }
+  if ( filter.hasDateFrom() ) {
+    q = Xapian::Query(Xapian::Query::OP_AND, q, Xapian::Query(Xapian::Query::OP_VALUE_GE, DATE_SLOT, filter.getDateFrom()));
+  }
+  if ( filter.hasDateTo() ) {
+    // Dates are compared as strings, so the dates of the last day (or month
+    // or year) of the period must be accepted despite being longer
+    const auto dateTo = filter.getDateTo() + "\xff";
+    q = Xapian::Query(Xapian::Query::OP_AND, q, Xapian::Query(Xapian::Query::OP_VALUE_LE, DATE_SLOT, dateTo));
+  }
   return q;
 }
 
+// The results of a filter without a text query are not ranked: the other
+// conditions of a filter only tell whether a book is selected or not. Then
+// the (cheaper) boolean weighting scheme is used and the books are listed
+// in the order they were added to the library.
+void setupEnquire(Xapian::Enquire& enquire, const Filter& filter, const Xapian::Query& query)
+{
+  enquire.set_query(query);
+  if ( !filter.hasQuery() || filter.getQuery().empty() ) {
+    enquire.set_weighting_scheme(Xapian::BoolWeight());
+    enquire.set_docid_order(Xapian::Enquire::ASCENDING);
+  }
+}
+
+// Returns whether the books can be ordered by the value stored in a slot
+// of the book DB (and sets the slot)
+bool getSortValueSlot(supportedListSortBy sortBy, Xapian::valueno& slot)
+{
+  switch ( sortBy ) {
+    case SIZE: slot = SIZE_SLOT; return true;
+    case DATE: slot = DATE_SLOT; return true;
+    default:   return false;
+  }
+}
+
 } // unnamed namespace
 
-Library::BookIdCollection Library::filterViaBookDB(const Filter& filter) const
+Library::BookIdCollection Library::filterViaBookDB(const Filter& filter, ConstSnapshotPtr& snapshot) const
 {
   const auto query = buildXapianQuery(filter);
 
-  if ( willSelectEverything(query) )
-    return getBooksIds();
+  if ( willSelectEverything(query) ) {
+    snapshot = getSnapshot();
+    return snapshot->getBooksIds();
+  }
 
   BookIdCollection bookIds;
 
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  // The book DB is not thread-safe, so it is queried under the lock. The
+  // snapshot published with the current state of the book DB is taken at
+  // the same time, so that the results can be checked against it.
+  LibraryLock lock(m_mutex);
+  snapshot = getSnapshot();
   Xapian::Enquire enquire(*m_bookDB);
-  enquire.set_query(query);
-  const auto results = enquire.get_mset(0, m_books.size());
+  setupEnquire(enquire, filter, query);
+  const auto results = enquire.get_mset(0, snapshot->m_books.size());
   for ( auto it = results.begin(); it != results.end(); ++it  ) {
     bookIds.push_back(it.get_document().get_data());
   }
@@ -773,99 +1045,248 @@ Library::BookIdCollection Library::filterViaBookDB(const Filter& filter) const
 }
 
 Library::BookIdCollection Library::filter(const Filter& filter) const
+{
+  // The revision in the key ensures that the results obtained before any
+  // change of the library are never used again (and are eventually
+  // evicted from the cache)
+  const auto key = std::to_string(getRevision()) + "/" + filter.getCanonicalForm();
+  ++m_filterCacheLookups;
+  return mp_filterCache->getOrPut(key, [&]() {
+    ++m_filterCacheMisses;
+    return filterNotCached(filter);
+  });
+}
+
+Library::FilterCacheStats Library::getFilterCacheStats() const
+{
+  FilterCacheStats stats;
+  stats.misses = m_filterCacheMisses;
+  stats.hits = m_filterCacheLookups - stats.misses;
+  return stats;
+}
+
+Library::BookIdCollection Library::filterNotCached(const Filter& filter) const
 {
   BookIdCollection result;
-  const auto preliminaryResult = filterViaBookDB(filter);
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  ConstSnapshotPtr snapshot;
+  const auto preliminaryResult = filterViaBookDB(filter, snapshot);
   for(auto id : preliminaryResult) {
-    if(filter.accept(m_books.at(id))) {
+    if(filter.accept(*snapshot->m_books.at(id))) {
       result.push_back(id);
     }
   }
   return result;
 }
 
-template<supportedListSortBy SORT>
-struct KEY_TYPE {
-  typedef std::string TYPE;
-};
-
-template<>
-struct KEY_TYPE<SIZE> {
-  typedef size_t TYPE;
-};
+namespace
+{
 
-template<supportedListSortBy sort>
-class Comparator {
-  private:
-    const Library* const lib;
-    const bool     ascending;
+// Rejects the matches of a Xapian query not satisfying the conditions
+// of a filter that are not part of the query
+class BookAcceptor : public Xapian::MatchDecider
+{
+  public:
+    typedef std::function<bool(const std::string& bookId)> Predicate;
 
-    inline typename KEY_TYPE<sort>::TYPE get_key(const std::string& id);
+    explicit BookAcceptor(Predicate predicate)
+      : m_predicate(predicate)
+    {}
 
-  public:
-    Comparator(const Library* lib, bool ascending) : lib(lib), ascending(ascending) {}
-    inline bool operator() (const std::string& id1, const std::string& id2) {
-      if (ascending) {
-        return get_key(id1) < get_key(id2);
-      } else {
-        return get_key(id2) < get_key(id1);
-      }
+    bool operator()(const Xapian::Document& doc) const override
+    {
+      return m_predicate(doc.get_data());
     }
+
+  private:
+    const Predicate m_predicate;
 };
 
-template<>
-std::string Comparator<TITLE>::get_key(const std::string& id)
+std::string makePageCursor(size_t nextIndex, const std::string& lastBookId)
 {
-  return lib->getBookById(id).getTitle();
+  return std::to_string(nextIndex) + ":" + lastBookId;
 }
 
-template<>
-size_t Comparator<SIZE>::get_key(const std::string& id)
+void parsePageCursor(const std::string& cursor, size_t& nextIndex, std::string& lastBookId)
 {
-  return lib->getBookById(id).getSize();
+  const auto sep = cursor.find(':');
+  if ( sep == 0 || sep > 18 || sep == std::string::npos || sep + 1 == cursor.size()
+       || cursor.find_first_not_of("0123456789") != sep ) {
+    throw std::invalid_argument("Invalid page cursor: " + cursor);
+  }
+  nextIndex = std::stoull(cursor.substr(0, sep));
+  lastBookId = cursor.substr(sep + 1);
 }
 
-template<>
-std::string Comparator<DATE>::get_key(const std::string& id)
+} // unnamed namespace
+
+Library::BookIdPage Library::filterPage(const Filter& filter, size_t start, size_t count,
+                                       supportedListSortBy sortBy, bool ascending) const
 {
-  return lib->getBookById(id).getDate();
+  Xapian::valueno slot = 0;
+  if ( sortBy == UNSORTED || getSortValueSlot(sortBy, slot) ) {
+    return getBookIdPage(filter, start, "", count, sortBy, ascending);
+  }
+
+  // All the results must be sorted before a page of them can be picked
+  auto bookIds = this->filter(filter);
+  sort(bookIds, sortBy, ascending);
+  BookIdPage page;
+  const size_t first = std::min(start, bookIds.size());
+  const size_t last = first + std::min(count, bookIds.size() - first);
+  page.bookIds.assign(bookIds.begin() + first, bookIds.begin() + last);
+  page.totalCount = bookIds.size();
+  page.startIndex = start;
+  return page;
 }
 
-template<>
-std::string Comparator<CREATOR>::get_key(const std::string& id)
+Library::BookIdPage Library::filterPageAfter(const Filter& filter, const std::string& cursor, size_t count) const
 {
-  return lib->getBookById(id).getCreator();
+  size_t start;
+  std::string lastBookId;
+  parsePageCursor(cursor, start, lastBookId);
+  return getBookIdPage(filter, start, lastBookId, count);
 }
 
-template<>
-std::string Comparator<PUBLISHER>::get_key(const std::string& id)
+Library::BookIdPage Library::getBookIdPage(const Filter& filter, size_t start, const std::string& lastBookId, size_t count,
+                                          supportedListSortBy sortBy, bool ascending) const
 {
-  return lib->getBookById(id).getPublisher();
+  const auto query = buildXapianQuery(filter);
+  const bool postFiltering = filter.hasBookAttributeConditions();
+  Xapian::valueno sortSlot = 0;
+  const bool sortByValue = getSortValueSlot(sortBy, sortSlot);
+  ConstSnapshotPtr snapshot;
+  const auto accept = [&](const std::string& bookId) {
+    return filter.accept(*snapshot->m_books.at(bookId));
+  };
+
+  BookIdPage page;
+  page.startIndex = start;
+  bool hasMore = false;
+
+  if ( willSelectEverything(query) && !sortByValue ) {
+    // The books are listed in the order of their ids. A page following
+    // another one is located by the id of the last book of the latter.
+    snapshot = getSnapshot();
+    const EntryMap& books = snapshot->m_books;
+    if ( !postFiltering ) {
+      auto it = books.begin();
+      if ( !lastBookId.empty() ) {
+        it = books.upper_bound(lastBookId);
+      } else {
+        std::advance(it, std::min(start, books.size()));
+      }
+      for ( ; it != books.end() && page.bookIds.size() < count; ++it ) {
+        page.bookIds.push_back(it->first);
+      }
+      page.totalCount = books.size();
+      hasMore = it != books.end();
+    } else {
+      // All accepted books must be visited in order to count them anyway
+      size_t index = 0;
+      for ( const auto& entry : books ) {
+        if ( !accept(entry.first) ) {
+          continue;
+        }
+        const bool beforePage = lastBookId.empty()
+                              ? index < start
+                              : entry.first <= lastBookId;
+        if ( beforePage ) {
+          if ( !lastBookId.empty() ) {
+            page.startIndex = index + 1;
+          }
+        } else if ( page.bookIds.size() < count ) {
+          page.bookIds.push_back(entry.first);
+        } else {
+          hasMore = true;
+        }
+        ++index;
+      }
+      page.totalCount = index;
+    }
+  } else {
+    // Only the requested page is collected from the (bounded) mset,
+    // but all matches are checked so that their count is exact.
+    // The book DB is queried under the lock (see filterViaBookDB()).
+    LibraryLock lock(m_mutex);
+    snapshot = getSnapshot();
+    const Xapian::doccount dbSize = m_bookDB->get_doccount();
+    Xapian::Enquire enquire(*m_bookDB);
+    setupEnquire(enquire, filter, query);
+    if ( sortByValue ) {
+      enquire.set_sort_by_value(sortSlot, !ascending);
+    }
+    const BookAcceptor acceptor(accept);
+    const auto results = enquire.get_mset(std::min<size_t>(start, dbSize),
+                                          std::min<size_t>(count, dbSize),
+                                          dbSize,
+                                          nullptr,
+                                          postFiltering ? &acceptor : nullptr);
+    for ( auto it = results.begin(); it != results.end(); ++it  ) {
+      page.bookIds.push_back(it.get_document().get_data());
+    }
+    page.totalCount = results.get_matches_estimated();
+    hasMore = start + page.bookIds.size() < page.totalCount;
+  }
+
+  if ( hasMore && !page.bookIds.empty() && sortBy == UNSORTED ) {
+    page.nextCursor = makePageCursor(page.startIndex + page.bookIds.size(),
+                                     page.bookIds.back());
+  }
+  return page;
 }
 
+namespace
+{
+
+// Sorts bookIds by the keys having the same indices
+template<class Key>
+void sortByKeys(Library::BookIdCollection& bookIds, const std::vector<Key>& keys, bool ascending)
+{
+  std::vector<size_t> order(bookIds.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t i1, size_t i2) {
+    return ascending ? keys[i1] < keys[i2] : keys[i2] < keys[i1];
+  });
+
+  Library::BookIdCollection sortedBookIds;
+  sortedBookIds.reserve(bookIds.size());
+  for ( const auto i : order ) {
+    sortedBookIds.push_back(std::move(bookIds[i]));
+  }
+  bookIds.swap(sortedBookIds);
+}
+
+} // unnamed namespace
+
 void Library::sort(BookIdCollection& bookIds, supportedListSortBy sort, bool ascending) const
 {
-  // NOTE: Can reimplement this method in a way that doesn't require locking
-  // NOTE: for the entire duration of the sort. Will need to obtain (under a
-  // NOTE: lock) the required atributes from the books once, and then the
-  // NOTE: sorting will run on a copy of data without locking.
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  // The sort keys are copied from a snapshot once per book, then the
+  // books are sorted by them.
+  const auto sortByBookKey = [&](auto getKey) {
+    const auto snapshot = getSnapshot();
+    std::vector<std::decay_t<decltype(getKey(std::declval<const Entry&>()))>> keys;
+    keys.reserve(bookIds.size());
+    for ( const auto& id : bookIds ) {
+      keys.push_back(getKey(*snapshot->m_books.at(id)));
+    }
+    sortByKeys(bookIds, keys, ascending);
+  };
+
   switch(sort) {
     case TITLE:
-      std::sort(bookIds.begin(), bookIds.end(), Comparator<TITLE>(this, ascending));
+      sortByBookKey([](const Entry& e) { return e.titleSortKey; });
       break;
     case SIZE:
-      std::sort(bookIds.begin(), bookIds.end(), Comparator<SIZE>(this, ascending));
+      sortByBookKey([](const Entry& e) { return e.getSize(); });
       break;
     case DATE:
-      std::sort(bookIds.begin(), bookIds.end(), Comparator<DATE>(this, ascending));
+      sortByBookKey([](const Entry& e) { return e.getDate(); });
       break;
     case CREATOR:
-      std::sort(bookIds.begin(), bookIds.end(), Comparator<CREATOR>(this, ascending));
+      sortByBookKey([](const Entry& e) { return e.getCreator(); });
       break;
     case PUBLISHER:
-      std::sort(bookIds.begin(), bookIds.end(), Comparator<PUBLISHER>(this, ascending));
+      sortByBookKey([](const Entry& e) { return e.getPublisher(); });
       break;
     default:
       break;
@@ -873,8 +1294,37 @@ void Library::sort(BookIdCollection& bookIds, supportedListSortBy sort, bool asc
 }
 
 
+namespace
+{
+
+bool isNumber(const std::string& s, size_t pos, size_t len)
+{
+  return s.size() >= pos + len
+      && std::all_of(s.begin() + pos, s.begin() + pos + len,
+                     [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// Throws std::invalid_argument unless the date is in the YYYY, YYYY-MM
+// or YYYY-MM-DD format
+void checkFilterDate(const std::string& date)
+{
+  const bool valid = isNumber(date, 0, 4)
+    && ( date.size() == 4
+      || ( date[4] == '-' && isNumber(date, 5, 2)
+        && date.substr(5, 2) >= "01" && date.substr(5, 2) <= "12"
+        && ( date.size() == 7
+          || ( date.size() == 10 && date[7] == '-' && isNumber(date, 8, 2)
+            && date.substr(8, 2) >= "01" && date.substr(8, 2) <= "31" ))));
+  if ( !valid ) {
+    throw std::invalid_argument("Invalid date: " + date);
+  }
+}
+
+} // unnamed namespace
+
 Filter::Filter()
   : activeFilters(0),
+    _minSize(0),
     _maxSize(0)
 {};
 
@@ -897,6 +1347,9 @@ enum filterTypes {
   NAME = FLAG(13),
   CATEGORY = FLAG(14),
   FLAVOUR = FLAG(15),
+  MINSIZE = FLAG(16),
+  DATEFROM = FLAG(17),
+  DATETO = FLAG(18),
 };
 
 Filter& Filter::local(bool accept)
@@ -984,6 +1437,29 @@ Filter& Filter::maxSize(size_t maxSize)
   return *this;
 }
 
+Filter& Filter::minSize(size_t minSize)
+{
+  _minSize = minSize;
+  activeFilters |= MINSIZE;
+  return *this;
+}
+
+Filter& Filter::dateFrom(std::string date)
+{
+  checkFilterDate(date);
+  _dateFrom = date;
+  activeFilters |= DATEFROM;
+  return *this;
+}
+
+Filter& Filter::dateTo(std::string date)
+{
+  checkFilterDate(date);
+  _dateTo = date;
+  activeFilters |= DATETO;
+  return *this;
+}
+
 Filter& Filter::query(std::string query, bool partial)
 {
   _query = query;
@@ -1055,6 +1531,75 @@ bool Filter::hasFlavour() const
   return ACTIVE(FLAVOUR);
 }
 
+bool Filter::hasMinSize() const
+{
+  return ACTIVE(MINSIZE);
+}
+
+bool Filter::hasMaxSize() const
+{
+  return ACTIVE(MAXSIZE);
+}
+
+bool Filter::hasDateFrom() const
+{
+  return ACTIVE(DATEFROM);
+}
+
+bool Filter::hasDateTo() const
+{
+  return ACTIVE(DATETO);
+}
+
+bool Filter::hasBookAttributeConditions() const
+{
+  return ACTIVE(_LOCAL | _NOLOCAL | _VALID | _NOVALID | _REMOTE | _NOREMOTE);
+}
+
+namespace
+{
+
+void appendField(std::string& out, const std::string& value)
+{
+  out += std::to_string(value.size());
+  out += ':';
+  out += value;
+}
+
+} // unnamed namespace
+
+std::string Filter::getCanonicalForm() const
+{
+  // Only the fields of the active filters contribute, so that filters
+  // selecting the same books in the same way have the same canonical form.
+  // The length prefix of every field keeps the form unambiguous.
+  std::string result = std::to_string(activeFilters);
+  const auto appendTags = [&result](const Tags& tags) {
+    auto sortedTags = tags;
+    std::sort(sortedTags.begin(), sortedTags.end());
+    result += '#' + std::to_string(sortedTags.size());
+    for ( const auto& tag : sortedTags ) {
+      appendField(result, tag);
+    }
+  };
+  if ( ACTIVE(ACCEPTTAGS) ) appendTags(_acceptTags);
+  if ( ACTIVE(REJECTTAGS) ) appendTags(_rejectTags);
+  if ( ACTIVE(CATEGORY) ) appendField(result, _category);
+  if ( ACTIVE(LANG) ) appendField(result, _lang);
+  if ( ACTIVE(_PUBLISHER) ) appendField(result, _publisher);
+  if ( ACTIVE(_CREATOR) ) appendField(result, _creator);
+  if ( ACTIVE(MINSIZE) ) appendField(result, std::to_string(_minSize));
+  if ( ACTIVE(MAXSIZE) ) appendField(result, std::to_string(_maxSize));
+  if ( ACTIVE(DATEFROM) ) appendField(result, _dateFrom);
+  if ( ACTIVE(DATETO) ) appendField(result, _dateTo);
+  if ( ACTIVE(QUERY) ) {
+    result += _queryIsPartial ? 'p' : 'f';
+    appendField(result, _query);
+  }
+  if ( ACTIVE(NAME) ) appendField(result, _name);
+  if ( ACTIVE(FLAVOUR) ) appendField(result, _flavour);
+  return result;
+}
 
 bool Filter::accept(const Book& book) const
 {
@@ -1070,8 +1615,6 @@ bool Filter::accept(const Book& book) const
   FILTER(_REMOTE, remote)
   FILTER(_NOREMOTE, !remote)
 
-  FILTER(MAXSIZE, book.getSize() <= _maxSize)
-
   return true;
 }
 
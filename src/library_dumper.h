@@ -26,7 +26,9 @@
 
 #include "library.h"
 #include "name_mapper.h"
+#include "tools/cancellation_token.h"
 #include <mustache.hpp>
+#include <memory>
 
 namespace kiwix
 {
@@ -66,6 +68,13 @@ class LibraryDumper
    */
   void setOpenSearchInfo(int totalResult, int startIndex, int count);
 
+  /**
+   * Set the cursor to the page of the search results following the current one.
+   *
+   * @param cursor the cursor (empty if the current page is the last one).
+   */
+  void setNextCursor(const std::string& cursor) { this->m_nextCursor = cursor; }
+
   /**
    * Sets user default language
    *
@@ -73,6 +82,16 @@ class LibraryDumper
    */
   void setUserLanguage(std::string userLang) { this->m_userLang = userLang; }
 
+  /**
+   * Set the token allowing to abort the dump of a long list of books
+   *
+   * If the token is cancelled while dumping books, the dump functions
+   * throw OperationCancelled.
+   *
+   * @param token the cancellation token
+   */
+  void setCancellationToken(std::shared_ptr<const CancellationToken> token) { this->m_cancellationToken = token; }
+
   /**
    * Get the data of categories
    */
@@ -83,6 +102,14 @@ class LibraryDumper
    */
   kainjow::mustache::list getLanguageData() const;
 
+ protected:
+  void throwIfCancelled() const
+  {
+    if ( m_cancellationToken ) {
+      m_cancellationToken->throwIfCancelled();
+    }
+  }
+
  protected:
   const kiwix::Library* const library;
   const kiwix::NameMapper* const nameMapper;
@@ -90,9 +117,11 @@ class LibraryDumper
   std::string rootLocation;
   std::string contentAccessUrl;
   std::string m_userLang;
+  std::shared_ptr<const CancellationToken> m_cancellationToken;
   int m_totalResults;
   int m_startIndex;
   int m_count;
+  std::string m_nextCursor;
 };
 }
 
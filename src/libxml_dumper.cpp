@@ -94,13 +94,13 @@ void LibXMLDumper::handleBookmark(Bookmark bookmark, pugi::xml_node root_node) {
   auto book_node = entry_node.append_child("book");
 
   try {
-    auto book = library->getBookByIdThreadSafe(bookmark.getBookId());
-    ADD_TEXT_ENTRY(book_node, "id", book.getId());
-    ADD_TEXT_ENTRY(book_node, "title", book.getTitle());
-    ADD_TEXT_ENTRY(book_node, "name", book.getName());
-    ADD_TEXT_ENTRY(book_node, "flavour", book.getFlavour());
-    ADD_TEXT_ENTRY(book_node, "language", book.getCommaSeparatedLanguages());
-    ADD_TEXT_ENTRY(book_node, "date", book.getDate());
+    const auto book = library->getBookPtrById(bookmark.getBookId());
+    ADD_TEXT_ENTRY(book_node, "id", book->getId());
+    ADD_TEXT_ENTRY(book_node, "title", book->getTitle());
+    ADD_TEXT_ENTRY(book_node, "name", book->getName());
+    ADD_TEXT_ENTRY(book_node, "flavour", book->getFlavour());
+    ADD_TEXT_ENTRY(book_node, "language", book->getCommaSeparatedLanguages());
+    ADD_TEXT_ENTRY(book_node, "date", book->getDate());
   } catch (...) {
     ADD_TEXT_ENTRY(book_node, "id", bookmark.getBookId());
     ADD_TEXT_ENTRY(book_node, "title", bookmark.getBookTitle());
@@ -125,7 +125,7 @@ std::string LibXMLDumper::dumpLibXMLContent(const std::vector<std::string>& book
 
   if (library) {
     for (auto& bookId: bookIds) {
-      handleBook(library->getBookById(bookId), libraryNode);
+      handleBook(*library->getBookPtrById(bookId), libraryNode);
     }
   }
   return nodeToString(libraryNode);
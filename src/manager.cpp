@@ -18,9 +18,13 @@
  */
 
 #include "manager.h"
+#include "zim_metadata_cache.h"
 
 #include "tools.h"
 #include "tools/pathTools.h"
+#include "tools/otherTools.h"
+#include "tools/binaryTools.h"
+#include "tools/worker_pool.h"
 
 #include <pugixml.hpp>
 #include <filesystem>
@@ -29,6 +33,8 @@
 #include <queue>
 #include <cctype>
 #include <algorithm>
+#include <memory>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -55,6 +61,23 @@ bool LibraryManipulator::addBookToLibrary(const Book& book)
   return ret;
 }
 
+size_t LibraryManipulator::addBooksToLibrary(const std::vector<Book>& books)
+{
+  const auto addedBookIds = library->addBooks(books);
+  // addedBookIds is a subsequence of the ids of books
+  auto addedBookIdIt = addedBookIds.begin();
+  for ( const auto& book : books ) {
+    if ( addedBookIdIt == addedBookIds.end() ) {
+      break;
+    }
+    if ( book.getId() == *addedBookIdIt ) {
+      bookWasAddedToLibrary(book);
+      ++addedBookIdIt;
+    }
+  }
+  return addedBookIds.size();
+}
+
 void LibraryManipulator::addBookmarkToLibrary(const Bookmark& bookmark)
 {
   library->addBookmark(bookmark);
@@ -99,29 +122,201 @@ Manager::Manager(LibraryPtr library) :
 {
 }
 
-bool Manager::parseXmlDom(const pugi::xml_document& doc,
-                          bool readOnly,
-                          const std::string& libraryPath,
-                          bool trustLibrary)
+void Manager::setZimMetadataCachePath(const std::string& path)
+{
+  mp_zimMetadataCache = path.empty()
+                      ? nullptr
+                      : std::make_shared<ZimMetadataCache>(path);
+}
+
+namespace
+{
+
+// Large library files are parsed by several threads, each of them
+// parsing at least that many books
+const size_t MIN_BOOKS_PER_PARSING_THREAD = 256;
+
+// Calls parseBooks(first, last) on consecutive slices of the books
+// [0, bookCount), concurrently if there are enough books. The threads are
+// only started for the time of the parsing since library files are rarely
+// read.
+template<class F>
+void parseBooksConcurrently(size_t bookCount, F parseBooks)
+{
+  static const size_t maxThreadCount = std::max(
+      getEnvVar<int>("KIWIX_LIBRARY_PARSING_THREADS",
+                     int(std::thread::hardware_concurrency())),
+      1);
+  const size_t threadCount = std::min(maxThreadCount, bookCount / MIN_BOOKS_PER_PARSING_THREAD);
+  std::unique_ptr<WorkerPool> pool;
+  if ( threadCount > 1 ) {
+    // The calling thread parses books too
+    pool.reset(new WorkerPool(threadCount - 1));
+  }
+  processInSlices(pool.get(), bookCount, MIN_BOOKS_PER_PARSING_THREAD,
+                  [&](size_t first, size_t last) {
+                    parseBooks(first, last);
+                    return last - first;
+                  });
+}
+
+const char LIBRARY_SNAPSHOT_MAGIC[] = "kiwix-library-snapshot";
+
+// Must be incremented whenever the format of the snapshots (including the
+// binary form of the books) changes
+const uint64_t LIBRARY_SNAPSHOT_VERSION = 1;
+
+// 64-bit FNV-1a hash
+uint64_t getContentHash(const std::string& content)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for ( const unsigned char c : content ) {
+    hash = (hash ^ c) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+std::string getLibrarySnapshotPath(const std::string& libraryPath)
+{
+  return libraryPath + ".snapshot";
+}
+
+// The header of a snapshot identifies the library file it was made from.
+// The path of the file is part of it since the relative paths of the
+// books are resolved from it.
+std::string makeLibrarySnapshotHeader(const std::string& libraryPath,
+                                      const std::string& libraryContent)
+{
+  std::string header;
+  BinaryWriter writer(header);
+  writer.writeString(LIBRARY_SNAPSHOT_MAGIC);
+  writer.writeInt(LIBRARY_SNAPSHOT_VERSION);
+  writer.writeString(libraryPath);
+  writer.writeInt(libraryContent.size());
+  writer.writeInt(getContentHash(libraryContent));
+  return header;
+}
+
+bool readLibrarySnapshot(const std::string& libraryPath,
+                         const std::string& libraryContent,
+                         std::vector<kiwix::Book>& books)
+{
+  const std::string snapshot = getFileContent(getLibrarySnapshotPath(libraryPath));
+  const std::string header = makeLibrarySnapshotHeader(libraryPath, libraryContent);
+  if ( snapshot.compare(0, header.size(), header) != 0 ) {
+    return false;
+  }
+
+  try {
+    BinaryReader reader(snapshot.data() + header.size(),
+                        snapshot.size() - header.size());
+    std::vector<kiwix::Book> snapshotBooks;
+    for ( auto n = reader.readInt(); n != 0; --n ) {
+      kiwix::Book book;
+      book.updateFromBinary(reader);
+      snapshotBooks.push_back(std::move(book));
+    }
+    if ( !reader.atEnd() ) {
+      return false;
+    }
+    books = std::move(snapshotBooks);
+    return true;
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+}
+
+// The snapshots are optional, so failing to write one isn't an error
+void writeLibrarySnapshot(const std::string& libraryPath,
+                          const std::string& libraryContent,
+                          const std::vector<kiwix::Book>& books)
+{
+  std::string snapshot = makeLibrarySnapshotHeader(libraryPath, libraryContent);
+  BinaryWriter writer(snapshot);
+  writer.writeInt(books.size());
+  for ( const auto& book : books ) {
+    book.writeBinary(writer);
+  }
+
+  writeFileAtomically(getLibrarySnapshotPath(libraryPath), snapshot);
+}
+
+} // unnamed namespace
+
+std::vector<kiwix::Book> Manager::readBooksFromXmlDom(const pugi::xml_document& doc,
+                                                      bool readOnly,
+                                                      const std::string& libraryPath,
+                                                      bool trustLibrary)
 {
   pugi::xml_node libraryNode = doc.child("library");
 
   std::string libraryVersion = libraryNode.attribute("version").value();
 
+  std::vector<pugi::xml_node> bookNodes;
   for (pugi::xml_node bookNode = libraryNode.child("book"); bookNode;
        bookNode = bookNode.next_sibling("book")) {
-    kiwix::Book book;
+    bookNodes.push_back(bookNode);
+  }
+
+  // Building a book checks that its file is readable (or even opens it
+  // if the library isn't trusted) and decodes its favicon, so the books
+  // are built concurrently. The document is only read, which pugixml
+  // allows from several threads.
+  const std::string baseDir = removeLastPathElement(libraryPath);
+  std::vector<kiwix::Book> books(bookNodes.size());
+  parseBooksConcurrently(books.size(), [&](size_t first, size_t last) {
+    for ( size_t i = first; i < last; ++i ) {
+      kiwix::Book& book = books[i];
+      book.setReadOnly(readOnly);
+      book.updateFromXml(bookNodes[i], baseDir);
+
+      if (!trustLibrary && !book.getPath().empty()) {
+        this->readBookFromPath(book.getPath(), &book);
+      }
+    }
+  });
+
+  if (!trustLibrary && mp_zimMetadataCache) {
+    mp_zimMetadataCache->save();
+  }
+  return books;
+}
 
-    book.setReadOnly(readOnly);
-    book.updateFromXml(bookNode,
-                       removeLastPathElement(libraryPath));
+bool Manager::parseXmlDom(const pugi::xml_document& doc,
+                          bool readOnly,
+                          const std::string& libraryPath,
+                          bool trustLibrary)
+{
+  manipulator.addBooksToLibrary(readBooksFromXmlDom(doc, readOnly, libraryPath, trustLibrary));
+  return true;
+}
 
-    if (!trustLibrary && !book.getPath().empty()) {
-      this->readBookFromPath(book.getPath(), &book);
+bool Manager::readFileUsingSnapshot(const std::string& path, bool readOnly)
+{
+  const std::string libraryPath = isRelativePath(path)
+                                ? computeAbsolutePath(getCurrentDirectory(), path)
+                                : path;
+  const std::string content = getFileContent(libraryPath);
+  std::vector<kiwix::Book> books;
+  if ( readLibrarySnapshot(libraryPath, content, books) ) {
+    // The files of the books may have appeared or disappeared since the
+    // snapshot was made
+    parseBooksConcurrently(books.size(), [&](size_t first, size_t last) {
+      for ( size_t i = first; i < last; ++i ) {
+        books[i].setReadOnly(readOnly);
+        books[i].setPathValid(fileReadable(books[i].getPath()));
+      }
+    });
+  } else {
+    pugi::xml_document doc;
+    if ( !doc.load_buffer(content.data(), content.size()) ) {
+      return false;
     }
-    manipulator.addBookToLibrary(book);
+    books = readBooksFromXmlDom(doc, readOnly, libraryPath, true);
+    writeLibrarySnapshot(libraryPath, content, books);
   }
 
+  manipulator.addBooksToLibrary(books);
   return true;
 }
 
@@ -156,6 +351,7 @@ bool Manager::parseOpdsDom(const pugi::xml_document& doc, const std::string& url
     m_hasSearchResult = false;
   }
 
+  std::vector<kiwix::Book> books;
   for (pugi::xml_node entryNode = libraryNode.child("entry"); entryNode;
        entryNode = entryNode.next_sibling("entry")) {
     kiwix::Book book;
@@ -163,9 +359,10 @@ bool Manager::parseOpdsDom(const pugi::xml_document& doc, const std::string& url
     book.setReadOnly(false);
     book.updateFromOpds(entryNode, urlHost);
 
-    /* Update the book properties with the new importer */
-    manipulator.addBookToLibrary(book);
+    books.push_back(std::move(book));
   }
+  /* Update the book properties with the new importer */
+  manipulator.addBooksToLibrary(books);
 
   return true;
 }
@@ -192,18 +389,22 @@ bool Manager::readFile(
   bool trustLibrary)
 {
   bool retVal = true;
-  pugi::xml_document doc;
+  if (m_librarySnapshotsEnabled && trustLibrary) {
+    retVal = this->readFileUsingSnapshot(path, readOnly);
+  } else {
+    pugi::xml_document doc;
 
 #ifdef _WIN32
-  pugi::xml_parse_result result = doc.load_file(Utf8ToWide(path).c_str());
+    pugi::xml_parse_result result = doc.load_file(Utf8ToWide(path).c_str());
 #else
-  pugi::xml_parse_result result = doc.load_file(path.c_str());
+    pugi::xml_parse_result result = doc.load_file(path.c_str());
 #endif
 
-  if (result) {
-    this->parseXmlDom(doc, readOnly, path, trustLibrary);
-  } else {
-    retVal = false;
+    if (result) {
+      this->parseXmlDom(doc, readOnly, path, trustLibrary);
+    } else {
+      retVal = false;
+    }
   }
 
   /* This has to be set (although if the file does not exists) to be
@@ -307,6 +508,9 @@ void Manager::addBooksFromDirectory(const std::string& path,
     iteratedDirs.insert(currentPath);
   }
 
+  if (mp_zimMetadataCache)
+    mp_zimMetadataCache->save();
+
   if (verboseFlag)
     std::cout << "Traversal completed. Total books added: " << totalBooksAdded << std::endl;
 }
@@ -318,9 +522,18 @@ bool Manager::readBookFromPath(const std::string& path, kiwix::Book* book)
     tmp_path = computeAbsolutePath(getCurrentDirectory(), path);
   }
   try {
+    FileStamp stamp;
+    const bool useCache = mp_zimMetadataCache && getFileStamp(tmp_path, &stamp);
+    if (useCache && mp_zimMetadataCache->get(tmp_path, stamp, book)) {
+      book->setPathValid(true);
+      return true;
+    }
     zim::Archive archive(tmp_path);
     book->update(archive);
     book->setPathValid(true);
+    if (useCache) {
+      mp_zimMetadataCache->put(tmp_path, stamp, *book);
+    }
   } catch (const std::exception& e) {
     book->setPathValid(false);
     return false;
@@ -26,8 +26,8 @@ namespace kiwix {
 
 HumanReadableNameMapper::HumanReadableNameMapper(const kiwix::Library& library, bool withAlias) {
   for (auto& bookId: library.filter(kiwix::Filter())) {
-    auto& currentBook = library.getBookById(bookId);
-    auto bookName = currentBook.getHumanReadableIdFromPath();
+    const auto currentBook = library.getBookPtrById(bookId);
+    auto bookName = currentBook->getHumanReadableIdFromPath();
     m_idToName[bookId] = bookName;
     mapName(library, bookName, bookId);
 
@@ -45,10 +45,10 @@ void HumanReadableNameMapper::mapName(const Library& library, std::string name,
   if (m_nameToId.find(name) == m_nameToId.end()) {
     m_nameToId[name] = bookId;
   } else {
-    const auto& currentBook = library.getBookById(bookId);
-    auto alreadyPresentPath = library.getBookById(m_nameToId[name]).getPath();
+    const auto currentBook = library.getBookPtrById(bookId);
+    auto alreadyPresentPath = library.getBookPtrById(m_nameToId[name])->getPath();
     std::cerr << "Path collision: '" << alreadyPresentPath
-              << "' and '" << currentBook.getPath()
+              << "' and '" << currentBook->getPath()
               << "' can't share the same URL path '" << name << "'."
               << " Therefore, only '" << alreadyPresentPath
               << "' will be served." << std::endl;
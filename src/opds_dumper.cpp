@@ -25,6 +25,7 @@
 
 #include "tools/stringTools.h"
 #include "tools/otherTools.h"
+#include "tools/worker_pool.h"
 
 namespace kiwix
 {
@@ -44,142 +45,318 @@ namespace
 
 const std::string XML_HEADER(R"(<?xml version="1.0" encoding="UTF-8"?>)");
 
-typedef kainjow::mustache::data MustacheData;
-typedef kainjow::mustache::list BooksData;
-typedef kainjow::mustache::list IllustrationInfo;
+// Rough sizes of a rendered entry used to preallocate the output buffer
+const size_t FULL_ENTRY_SIZE_ESTIMATE = 1536;
+const size_t PARTIAL_ENTRY_SIZE_ESTIMATE = 384;
+const size_t FEED_HEADER_SIZE_ESTIMATE = 1024;
+const size_t FEED_FOOTER_SIZE = 8;
 
-IllustrationInfo getBookIllustrationInfo(const Book& book)
+// Appends OPDS/Atom markup to a string buffer. Markup is appended as is,
+// while text values are escaped exactly like mustache escapes {{variables}}
+// (so that the output is identical to what the former templates produced).
+class XMLWriter
 {
-    kainjow::mustache::list illustrations;
-    for ( const auto& illustration : book.getIllustrations() ) {
+  public:
+    explicit XMLWriter(std::string& out) : m_out(out) {}
+
+    XMLWriter& raw(const char* markup)        { m_out += markup; return *this; }
+    XMLWriter& raw(const std::string& markup) { m_out += markup; return *this; }
+
+    XMLWriter& text(const std::string& value)
+    {
+      for ( const char c : value ) {
+        switch ( c ) {
+          case '&':  m_out += "&amp;";  break;
+          case '<':  m_out += "&lt;";   break;
+          case '>':  m_out += "&gt;";   break;
+          case '"':  m_out += "&quot;"; break;
+          case '\'': m_out += "&apos;"; break;
+          default:   m_out += c;        break;
+        }
+      }
+      return *this;
+    }
+
+  private:
+    std::string& m_out;
+};
+
+void writeFullEntry(XMLWriter& w,
+                    const Book& book,
+                    const std::string& rootLocation,
+                    const std::string& contentAccessUrl,
+                    const std::string& contentId)
+{
+    // XXX: the entry update datetime should be used for <updated>
+    const auto bookDate = book.getDate() + "T00:00:00Z";
+    w.raw("  <entry>\n"
+          "    <id>urn:uuid:").text(book.getId()).raw("</id>\n"
+          "    <title>").text(book.getTitle()).raw("</title>\n"
+          "    <updated>").text(bookDate).raw("</updated>\n"
+          "    <summary>").text(book.getDescription()).raw("</summary>\n"
+          "    <language>").text(book.getCommaSeparatedLanguages()).raw("</language>\n"
+          "    <name>").text(book.getName()).raw("</name>\n"
+          "    <flavour>").text(book.getFlavour()).raw("</flavour>\n"
+          "    <category>").text(book.getCategory()).raw("</category>\n"
+          "    <tags>").text(book.getTags()).raw("</tags>\n"
+          "    <articleCount>").raw(to_string(book.getArticleCount())).raw("</articleCount>\n"
+          "    <mediaCount>").raw(to_string(book.getMediaCount())).raw("</mediaCount>\n");
+
+    const auto illustrations = book.getIllustrations();
+    for ( const auto& illustration : illustrations ) {
       // For now, we are handling only sizexsize@1 illustration.
-      // So we can simply pass one size to mustache.
-      illustrations.push_back(kainjow::mustache::object{
-        {"icon_size", to_string(illustration->width)},
-        {"icon_mimetype", illustration->mimeType}
-      });
+      const auto size = to_string(illustration->width);
+      w.raw("    <link rel=\"http://opds-spec.org/image/thumbnail\"\n"
+            "          href=\"").text(rootLocation).raw("/catalog/v2/illustration/").raw(book.getId()).raw("/?size=").text(size).raw("\"\n"
+            "          type=\"").text(illustration->mimeType).raw(";width=").text(size).raw(";height=").text(size).raw(";scale=1\"/>\n");
+    }
+
+    if ( !contentAccessUrl.empty() ) {
+      w.raw("    <link type=\"text/html\" href=\"").text(contentAccessUrl).raw("/").raw(urlEncode(contentId)).raw("\" />\n");
+    } else if ( illustrations.empty() ) {
+      // The template that used to render the entries left a whitespace-only
+      // line when neither of the optional links above was present (and
+      // nothing when only the illustrations were). This is kept for backward
+      // compatibility.
+      w.raw("    \n");
     }
-    return illustrations;
+
+    w.raw("    <author>\n"
+          "      <name>").text(book.getCreator()).raw("</name>\n"
+          "    </author>\n"
+          "    <publisher>\n"
+          "      <name>").text(book.getPublisher()).raw("</name>\n"
+          "    </publisher>\n"
+          "    <dc:issued>").text(bookDate).raw("</dc:issued>\n");
+
+    if ( !book.getUrl().empty() ) {
+      w.raw("    <link rel=\"http://opds-spec.org/acquisition/open-access\" type=\"application/x-zim\" href=\"").raw(book.getUrl()).raw("\" length=\"").raw(to_string(book.getSize())).raw("\" />\n");
+    } else {
+      // whitespace-only line left by the template, as above
+      w.raw("    \n");
+    }
+    w.raw("  </entry>\n");
 }
 
-std::string fullEntryXML(const Book& book,
-                         const std::string& rootLocation,
-                         const std::string& contentAccessUrl,
-                         const std::string& contentId)
+void writePartialEntry(XMLWriter& w, const Book& book, const std::string& rootLocation)
 {
+    // XXX: the entry update datetime should be used for <updated>
     const auto bookDate = book.getDate() + "T00:00:00Z";
-    const kainjow::mustache::object data{
-      {"root",  rootLocation},
-      {"contentAccessUrl",  onlyAsNonEmptyMustacheValue(contentAccessUrl)},
-      {"id", book.getId()},
-      {"name", book.getName()},
-      {"title", book.getTitle()},
-      {"description", book.getDescription()},
-      {"language", book.getCommaSeparatedLanguages()},
-      {"content_id",  urlEncode(contentId)},
-      {"updated", bookDate}, // XXX: this should be the entry update datetime
-      {"book_date", bookDate},
-      {"category", book.getCategory()},
-      {"flavour", book.getFlavour()},
-      {"tags", book.getTags()},
-      {"article_count", to_string(book.getArticleCount())},
-      {"media_count", to_string(book.getMediaCount())},
-      {"author_name", book.getCreator()},
-      {"publisher_name", book.getPublisher()},
-      {"url", onlyAsNonEmptyMustacheValue(book.getUrl())},
-      {"size", to_string(book.getSize())},
-      {"icons", getBookIllustrationInfo(book)},
-    };
-    return render_template(RESOURCE::templates::catalog_v2_entry_xml, data);
-}
-
-std::string partialEntryXML(const Book& book, const std::string& rootLocation)
+    w.raw("  <entry>\n"
+          "    <id>urn:uuid:").text(book.getId()).raw("</id>\n"
+          "    <title>").text(book.getTitle()).raw("</title>\n"
+          "    <updated>").text(bookDate).raw("</updated>\n"
+          "    <link rel=\"alternate\"\n"
+          "          href=\"").text(rootLocation).raw("/catalog/v2/entry/").raw(book.getId()).raw("\"\n"
+          "          type=\"application/atom+xml;type=entry;profile=opds-catalog\"/>\n"
+          "  </entry>\n");
+}
+
+// Writes the <totalResults>, <startIndex> and <itemsPerPage> elements of a
+// filtered feed (an unfiltered feed has an empty line instead)
+void writeFilterInfo(XMLWriter& w,
+                     const std::string& query,
+                     size_t totalResults,
+                     size_t startIndex,
+                     size_t count)
 {
-    const auto bookDate = book.getDate() + "T00:00:00Z";
-    const kainjow::mustache::object data{
-      {"root",  rootLocation},
-      {"endpoint_root", rootLocation + "/catalog/v2"},
-      {"id", book.getId()},
-      {"title", book.getTitle()},
-      {"updated", bookDate}, // XXX: this should be the entry update datetime
-    };
-    const auto xmlTemplate = RESOURCE::templates::catalog_v2_partial_entry_xml;
-    return render_template(xmlTemplate, data);
-}
-
-BooksData getBooksData(const Library* library,
-                       const NameMapper* nameMapper,
-                       const std::vector<std::string>& bookIds,
-                       const std::string& rootLocation,
-                       const std::string& contentAccessUrl,
-                       bool partial)
-{
-  BooksData booksData;
-  for ( const auto& bookId : bookIds ) {
+  if ( query.empty() ) {
+    w.raw("\n");
+    return;
+  }
+
+  w.raw("  <totalResults>").raw(to_string(totalResults)).raw("</totalResults>\n"
+        "  <startIndex>").raw(to_string(startIndex)).raw("</startIndex>\n"
+        "  <itemsPerPage>").raw(to_string(count)).raw("</itemsPerPage>\n");
+}
+
+size_t estimateEntriesSize(size_t bookCount, bool partial)
+{
+  const auto entrySize = partial ? PARTIAL_ENTRY_SIZE_ESTIMATE
+                                 : FULL_ENTRY_SIZE_ESTIMATE;
+  return bookCount * entrySize;
+}
+
+// Entries of large feeds are rendered by several threads, each of them
+// rendering at least that many entries
+const size_t MIN_ENTRIES_PER_RENDERING_THREAD = 64;
+
+} // unnamed namespace
+
+string OPDSDumper::dumpOPDSFeedHeader(const std::string& query) const
+{
+  std::string header;
+  header.reserve(FEED_HEADER_SIZE_ESTIMATE);
+  XMLWriter w(header);
+  w.raw("<feed xmlns=\"http://www.w3.org/2005/Atom\"\n"
+        "      xmlns:dc=\"http://purl.org/dc/terms/\"\n"
+        "      xmlns:opds=\"http://opds-spec.org/2010/catalog\">\n"
+        "  <id>").text(gen_uuid(libraryId + "/catalog/search?"+query)).raw("</id>\n");
+  if ( query.empty() ) {
+    w.raw("  <title>All zims</title>\n");
+  } else {
+    w.raw("  <title>Filtered zims (").text(query).raw(")</title>\n");
+  }
+  w.raw("  <updated>").text(gen_date_str()).raw("</updated>\n");
+  writeFilterInfo(w, query, m_totalResults, m_startIndex, m_count);
+  w.raw("  <link rel=\"self\" href=\"\" type=\"application/atom+xml\" />\n"
+        "  <link rel=\"search\" type=\"application/opensearchdescription+xml\" href=\"").text(rootLocation).raw("/catalog/searchdescription.xml\" />\n");
+  return header;
+}
+
+string OPDSDumper::dumpOPDSFeedV2Header(const std::string& query, bool partial) const
+{
+  const auto endpointRoot = rootLocation + "/catalog/v2";
+  const char* const endpoint = partial ? "/partial_entries" : "/entries";
+  const std::string url = endpoint + (query.empty() ? "" : "?" + query);
+
+  std::string header;
+  header.reserve(FEED_HEADER_SIZE_ESTIMATE);
+  XMLWriter w(header);
+  w.raw(XML_HEADER).raw("\n"
+        "<feed xmlns=\"http://www.w3.org/2005/Atom\"\n"
+        "      xmlns:dc=\"http://purl.org/dc/terms/\"\n"
+        "      xmlns:opds=\"https://specs.opds.io/opds-1.2\"\n"
+        "      xmlns:opensearch=\"http://a9.com/-/spec/opensearch/1.1/\">\n"
+        "  <id>").text(gen_uuid(libraryId + endpoint + "?" + query)).raw("</id>\n"
+        "\n"
+        "  <link rel=\"self\"\n"
+        "        href=\"").text(endpointRoot).text(url).raw("\"\n"
+        "        type=\"application/atom+xml;profile=opds-catalog;kind=acquisition\"/>\n"
+        "  <link rel=\"start\"\n"
+        "        href=\"").text(endpointRoot).raw("/root.xml\"\n"
+        "        type=\"application/atom+xml;profile=opds-catalog;kind=navigation\"/>\n"
+        "  <link rel=\"up\"\n"
+        "        href=\"").text(endpointRoot).raw("/root.xml\"\n"
+        "        type=\"application/atom+xml;profile=opds-catalog;kind=navigation\"/>\n"
+        "\n");
+  if ( query.empty() ) {
+    w.raw("  <title>All Entries</title>\n");
+  } else {
+    w.raw("  <title>Filtered Entries (").text(query).raw(")</title>\n");
+  }
+  w.raw("  <updated>").text(gen_date_str()).raw("</updated>\n");
+  writeFilterInfo(w, query, m_totalResults, m_startIndex, m_count);
+  return header;
+}
+
+std::string OPDSDumper::renderEntry(const Book& book, bool partial) const
+{
+  std::string xml;
+  xml.reserve(partial ? PARTIAL_ENTRY_SIZE_ESTIMATE : FULL_ENTRY_SIZE_ESTIMATE);
+  XMLWriter w(xml);
+  if ( partial ) {
+    writePartialEntry(w, book, rootLocation);
+  } else {
+    const std::string contentId = nameMapper->getNameForId(book.getId());
+    writeFullEntry(w, book, rootLocation, contentAccessUrl, contentId);
+  }
+  return xml;
+}
+
+std::string OPDSDumper::getEntryCacheKey(const Library::Snapshot& snapshot, const std::string& bookId, bool partial) const
+{
+  const auto lastUpdatedRevision = snapshot.getLastUpdatedRevision(bookId);
+  const std::string contentId = partial ? "" : nameMapper->getNameForId(bookId);
+  // Book ids never contain a slash, so the key is unambiguous
+  return (partial ? "partial/" : "full/")
+       + to_string(lastUpdatedRevision) + "/"
+       + bookId + "/" + contentId;
+}
+
+std::string OPDSDumper::getEntryXML(const Library::Snapshot& snapshot, const std::string& bookId, bool partial) const
+{
+  // The book and the revision of its last update must come from the same
+  // state of the library
+  const Book& book = snapshot.getBookById(bookId);
+  if ( !mp_entryCache ) {
+    return renderEntry(book, partial);
+  }
+
+  const auto key = getEntryCacheKey(snapshot, bookId, partial);
+  return mp_entryCache->getOrPut(key, [&]() { return renderEntry(book, partial); });
+}
+
+void OPDSDumper::appendEntries(std::string& out, const std::vector<std::string>& bookIds, bool partial) const
+{
+  const auto snapshot = library->getSnapshot();
+
+  // The entries found in the cache are taken on this thread, so that only
+  // the missing ones are rendered (by several threads for large feeds).
+  // The entries of the books missing from the library stay empty.
+  std::vector<std::string> entries(bookIds.size());
+  std::vector<size_t> missingEntries;
+  for ( size_t i = 0; i < bookIds.size(); ++i ) {
+    if ( !mp_entryCache ) {
+      missingEntries.push_back(i);
+      continue;
+    }
     try {
-      const Book book = library->getBookByIdThreadSafe(bookId);
-      const std::string contentId = nameMapper->getNameForId(bookId);
-      const auto entryXML = partial
-                          ? partialEntryXML(book, rootLocation)
-                          : fullEntryXML(book, rootLocation, contentAccessUrl, contentId);
-      booksData.push_back(kainjow::mustache::object{ {"entry", entryXML} });
+      const auto key = getEntryCacheKey(*snapshot, bookIds[i], partial);
+      if ( !mp_entryCache->getIfReady(key, entries[i]) ) {
+        missingEntries.push_back(i);
+      }
     } catch ( const std::out_of_range& ) {
       // the book was removed from the library since its id was obtained
       // ignore it
     }
   }
 
-  return booksData;
+  const auto renderSlice = [&](size_t first, size_t last) {
+    for ( size_t k = first; k < last; ++k ) {
+      throwIfCancelled();
+      const size_t i = missingEntries[k];
+      try {
+        entries[i] = getEntryXML(*snapshot, bookIds[i], partial);
+      } catch ( const std::out_of_range& ) {
+        // the book was removed from the library since its id was obtained
+        // ignore it
+      }
+    }
+    return last - first;
+  };
+  processInSlices(mp_renderingPool.get(), missingEntries.size(),
+                  MIN_ENTRIES_PER_RENDERING_THREAD, renderSlice);
+
+  for ( const auto& entry : entries ) {
+    out += entry;
+  }
 }
 
-} // unnamed namespace
+string OPDSDumper::dumpOPDSEntries(const std::vector<std::string>& bookIds, bool partial) const
+{
+  std::string entries;
+  entries.reserve(estimateEntriesSize(bookIds.size(), partial));
+  appendEntries(entries, bookIds, partial);
+  return entries;
+}
 
-string OPDSDumper::dumpOPDSFeed(const std::vector<std::string>& bookIds, const std::string& query) const
+string OPDSDumper::dumpOPDSFeedFooter()
 {
-  const auto booksData = getBooksData(library, nameMapper, bookIds, rootLocation, contentAccessUrl, false);
-  const kainjow::mustache::object template_data{
-     {"date", gen_date_str()},
-     {"root", rootLocation},
-     {"feed_id", gen_uuid(libraryId + "/catalog/search?"+query)},
-     {"filter", onlyAsNonEmptyMustacheValue(query)},
-     {"totalResults", to_string(m_totalResults)},
-     {"startIndex", to_string(m_startIndex)},
-     {"itemsPerPage", to_string(m_count)},
-     {"books", booksData }
-  };
+  return "</feed>\n";
+}
 
-  return render_template(RESOURCE::templates::catalog_entries_xml, template_data);
+string OPDSDumper::dumpOPDSFeed(const std::vector<std::string>& bookIds, const std::string& query) const
+{
+  std::string feed = dumpOPDSFeedHeader(query);
+  feed.reserve(feed.size() + estimateEntriesSize(bookIds.size(), false) + FEED_FOOTER_SIZE);
+  appendEntries(feed, bookIds, false);
+  feed += dumpOPDSFeedFooter();
+  return feed;
 }
 
 string OPDSDumper::dumpOPDSFeedV2(const std::vector<std::string>& bookIds, const std::string& query, bool partial) const
 {
-  const auto endpointRoot = rootLocation + "/catalog/v2";
-  const auto booksData = getBooksData(library, nameMapper, bookIds, rootLocation, contentAccessUrl, partial);
-
-  const char* const endpoint = partial ? "/partial_entries" : "/entries";
-  const std::string url = endpoint + (query.empty() ? "" : "?" + query);
-  const kainjow::mustache::object template_data{
-     {"date", gen_date_str()},
-     {"endpoint_root", endpointRoot},
-     {"feed_id", gen_uuid(libraryId + endpoint + "?" + query)},
-     {"filter", onlyAsNonEmptyMustacheValue(query)},
-     {"self_url", url},
-     {"totalResults", to_string(m_totalResults)},
-     {"startIndex", to_string(m_startIndex)},
-     {"itemsPerPage", to_string(m_count)},
-     {"books", booksData }
-  };
-
-  return render_template(RESOURCE::templates::catalog_v2_entries_xml, template_data);
+  std::string feed = dumpOPDSFeedV2Header(query, partial);
+  feed.reserve(feed.size() + estimateEntriesSize(bookIds.size(), partial) + FEED_FOOTER_SIZE);
+  appendEntries(feed, bookIds, partial);
+  feed += dumpOPDSFeedFooter();
+  return feed;
 }
 
 std::string OPDSDumper::dumpOPDSCompleteEntry(const std::string& bookId) const
 {
-  const auto book = library->getBookById(bookId);
-  const std::string contentId = nameMapper->getNameForId(bookId);
-  return XML_HEADER
-         + "\n"
-         + fullEntryXML(book, rootLocation, contentAccessUrl, contentId);
+  return XML_HEADER + "\n" + getEntryXML(*library->getSnapshot(), bookId, /*partial=*/false);
 }
 
 std::string OPDSDumper::categoriesOPDSFeed() const
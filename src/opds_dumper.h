@@ -29,12 +29,30 @@
 #include "library.h"
 #include "name_mapper.h"
 #include "library_dumper.h"
+#include "tools/concurrent_cache.h"
 
 using namespace std;
 
 namespace kiwix
 {
 
+class WorkerPool;
+
+/**
+ * A cache of rendered OPDS entries.
+ *
+ * The entries of a book are identified by the book id and the library
+ * revision of the last update of the book, so that they are rendered again
+ * only after the book changes. A cache may be shared only by dumpers
+ * rendering the same library with the same root location and content
+ * access URL.
+ */
+class OPDSEntryCache : public ConcurrentCache<std::string, std::string>
+{
+ public:
+  using ConcurrentCache::ConcurrentCache;
+};
+
 /**
  * A tool to dump a `Library` into a opds stream.
  *
@@ -64,6 +82,48 @@ class OPDSDumper : public LibraryDumper
    */
   std::string dumpOPDSFeedV2(const std::vector<std::string>& bookIds, const std::string& query, bool partial) const;
 
+  /**
+   * Dump the part of the OPDS feed preceding the entries.
+   *
+   * dumpOPDSFeed(bookIds, query) is the same as
+   * dumpOPDSFeedHeader(query) + dumpOPDSEntries(bookIds, false) + dumpOPDSFeedFooter()
+   *
+   * @param query the query used to obtain the list of book ids
+   * @return The beginning of the OPDS feed.
+   */
+  std::string dumpOPDSFeedHeader(const std::string& query) const;
+
+  /**
+   * Dump the part of the (v2) OPDS feed preceding the entries.
+   *
+   * dumpOPDSFeedV2(bookIds, query, partial) is the same as
+   * dumpOPDSFeedV2Header(query, partial) + dumpOPDSEntries(bookIds, partial) + dumpOPDSFeedFooter()
+   *
+   * @param query the query used to obtain the list of book ids
+   * @param partial whether the feed includes partial or complete entries
+   * @return The beginning of the OPDS feed.
+   */
+  std::string dumpOPDSFeedV2Header(const std::string& query, bool partial) const;
+
+  /**
+   * Dump the entries of an OPDS feed.
+   *
+   * Allows to produce a large feed piece by piece. Books missing from the
+   * library are skipped.
+   *
+   * @param bookIds the ids of the books to dump
+   * @param partial whether to dump partial or complete entries
+   * @return The OPDS entries.
+   */
+  std::string dumpOPDSEntries(const std::vector<std::string>& bookIds, bool partial) const;
+
+  /**
+   * Dump the end of an OPDS feed (following the entries).
+   *
+   * @return The end of the OPDS feed.
+   */
+  static std::string dumpOPDSFeedFooter();
+
   /**
    * Dump the OPDS complete entry document.
    *
@@ -85,6 +145,31 @@ class OPDSDumper : public LibraryDumper
    * @return The OPDS feed.
    */
   std::string languagesOPDSFeed() const;
+
+  /**
+   * Set the cache of the rendered entries.
+   *
+   * @param cache the cache to use (entries are rendered every time if null)
+   */
+  void setEntryCache(std::shared_ptr<OPDSEntryCache> cache) { mp_entryCache = cache; }
+
+  /**
+   * Set the threads helping to render the entries of large feeds.
+   *
+   * @param pool the threads to use (entries are rendered only by the
+   *             calling thread if null)
+   */
+  void setRenderingPool(std::shared_ptr<WorkerPool> pool) { mp_renderingPool = pool; }
+
+ private:
+  std::string renderEntry(const Book& book, bool partial) const;
+  std::string getEntryCacheKey(const Library::Snapshot& snapshot, const std::string& bookId, bool partial) const;
+  std::string getEntryXML(const Library::Snapshot& snapshot, const std::string& bookId, bool partial) const;
+  void appendEntries(std::string& out, const std::vector<std::string>& bookIds, bool partial) const;
+
+ private:
+  std::shared_ptr<OPDSEntryCache> mp_entryCache;
+  std::shared_ptr<WorkerPool> mp_renderingPool;
 };
 }
 
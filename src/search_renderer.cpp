@@ -203,7 +203,7 @@ std::string SearchRenderer::renderTemplate(const std::string& tmpl_str, const Na
     result.set("absolutePath", absPathPrefix + urlEncode(path));
     result.set("snippet", it.getSnippet());
     if (library) {
-      const std::string bookTitle = library->getBookById(zim_id).getTitle();
+      const std::string bookTitle = library->getBookPtrById(zim_id)->getTitle();
       const ParameterizedMessage bookInfoMsg("search-result-book-info",
           {{"BOOK_TITLE", bookTitle}}
       );
@@ -71,7 +71,8 @@ bool Server::start() {
     m_indexTemplateString,
     m_ipConnectionLimit,
     m_catalogOnlyMode,
-    m_contentServerUrl));
+    m_contentServerUrl,
+    m_opdsStreamingThreshold));
   if (mp_server->start()) {
     // this syncs m_addr of InternalServer and Server as they may diverge
     m_addr = mp_server->getAddress();
@@ -61,6 +61,7 @@ class ETag
     ETag() {}
 
     void set_body(const std::string& s) { m_body = s; }
+    const std::string& get_body() const { return m_body; }
     void set_option(Option opt);
 
     explicit operator bool() const { return !m_body.empty(); }
@@ -21,6 +21,9 @@
 
 #ifndef _WIN32
 #include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <cerrno>
 #endif
 
 #ifdef _WIN32
@@ -49,12 +52,17 @@ extern "C" {
 #include "tools/stringTools.h"
 #include "tools/archiveTools.h"
 #include "tools/networkTools.h"
+#include "tools/otherTools.h"
+#include "tools/tracepoints.h"
+#include "tools/instrumented_lock.h"
+#include "tools/worker_pool.h"
 #include "library.h"
 #include "name_mapper.h"
 #include "search_renderer.h"
 #include "opds_dumper.h"
 #include "html_dumper.h"
 #include "i18n_utils.h"
+#include "lock_stats.h"
 
 #include <zim/uuid.h>
 #include <zim/error.h>
@@ -68,7 +76,11 @@ extern "C" {
 #include <string>
 #include <vector>
 #include <chrono>
+#include <limits>
+#include <map>
 #include <fstream>
+#include <thread>
+#include <sstream>
 #include "libkiwix-resources.h"
 
 #ifndef _WIN32
@@ -79,6 +91,7 @@ extern "C" {
 #include "response.h"
 
 #define DEFAULT_CACHE_SIZE 2
+#define DEFAULT_OPDS_ENTRY_CACHE_SIZE 10000
 
 namespace kiwix {
 
@@ -187,6 +200,16 @@ std::string getSearchComponent(const RequestContext& request)
     return query.empty() ? query : "?" + query;
 }
 
+// Throws std::invalid_argument if the value isn't a number of bytes
+size_t parseSizeParam(const std::string& value)
+{
+  if ( value.empty() || value.find_first_not_of("0123456789") != std::string::npos ) {
+    throw std::invalid_argument("Invalid size: " + value);
+  }
+  return extractFromString<unsigned long>(value);
+}
+
+// Throws std::invalid_argument if the value of a parameter is invalid
 Filter get_search_filter(const RequestContext& request, const std::string& prefix="", bool catalogOnlyMode = false)
 {
     auto filter = kiwix::Filter();
@@ -197,8 +220,17 @@ Filter get_search_filter(const RequestContext& request, const std::string& prefi
       filter.query(request.get_argument(prefix+"q"));
     } catch (const std::out_of_range&) {}
     try {
-      filter.maxSize(request.get_argument<unsigned long>(prefix+"maxsize"));
-    } catch (...) {}
+      filter.minSize(parseSizeParam(request.get_argument(prefix+"minsize")));
+    } catch (const std::out_of_range&) {}
+    try {
+      filter.maxSize(parseSizeParam(request.get_argument(prefix+"maxsize")));
+    } catch (const std::out_of_range&) {}
+    try {
+      filter.dateFrom(request.get_argument(prefix+"datefrom"));
+    } catch (const std::out_of_range&) {}
+    try {
+      filter.dateTo(request.get_argument(prefix+"dateto"));
+    } catch (const std::out_of_range&) {}
     try {
       filter.name(request.get_argument(prefix+"name"));
     } catch (const std::out_of_range&) {}
@@ -217,11 +249,28 @@ Filter get_search_filter(const RequestContext& request, const std::string& prefi
     return filter;
 }
 
-template<class T>
-std::vector<T> subrange(const std::vector<T>& v, size_t s, size_t n)
+// Parses the value of the "sort" parameter of the catalog endpoints: the
+// name of a book attribute, prefixed with '-' for the descending order.
+bool parseSortParam(std::string param, supportedListSortBy& sortBy, bool& ascending)
 {
-  const size_t e = std::min(v.size(), s+n);
-  return std::vector<T>(v.begin()+std::min(v.size(), s), v.begin()+e);
+  static const std::map<std::string, supportedListSortBy> sortKeys = {
+    {"title",     TITLE},
+    {"size",      SIZE},
+    {"date",      DATE},
+    {"creator",   CREATOR},
+    {"publisher", PUBLISHER}
+  };
+
+  ascending = !startsWith(param, "-");
+  if ( !ascending ) {
+    param.erase(0, 1);
+  }
+  const auto it = sortKeys.find(param);
+  if ( it == sortKeys.end() ) {
+    return false;
+  }
+  sortBy = it->second;
+  return true;
 }
 
 std::string renderUrl(const std::string& root, const std::string& urlTemplate)
@@ -297,7 +346,7 @@ typedef std::set<std::string> Languages;
 Languages getLanguages(const Library& lib, const Library::BookIdSet& bookIds) {
   Languages langs;
   for ( const auto& b : bookIds ) {
-    const auto bookLangs = lib.getBookById(b).getLanguages();
+    const auto bookLangs = lib.getBookPtrById(b)->getLanguages();
     langs.insert(bookLangs.begin(), bookLangs.end());
   }
   return langs;
@@ -313,7 +362,8 @@ bool responseMustBeETaggedWithLibraryId(const Response& response, const RequestC
 {
   return response.getReturnCode() == MHD_HTTP_OK
       && response.get_kind() == Response::DYNAMIC_CONTENT
-      && request.get_url() != "/random";
+      && request.get_url() != "/random"
+      && request.get_url() != "/stats/locks";
 }
 
 ETag
@@ -332,6 +382,20 @@ struct NoDelete
   template<class T> void operator()(T*) {}
 };
 
+// The threads helping to render the entries of large OPDS feeds are shared
+// by all requests, the thread handling a request rendering a part of the
+// entries too. Hence at most KIWIX_OPDS_RENDERING_THREADS threads render
+// the entries of a feed.
+std::shared_ptr<WorkerPool> createOPDSRenderingPool()
+{
+  const int threadCount = getEnvVar<int>("KIWIX_OPDS_RENDERING_THREADS",
+                                         int(std::thread::hardware_concurrency()));
+  if ( threadCount <= 1 ) {
+    return nullptr;
+  }
+  return std::make_shared<WorkerPool>(threadCount - 1);
+}
+
 } // unnamed namespace
 
 std::pair<std::string, Library::BookIdSet> InternalServer::selectBooks(const RequestContext& request) const
@@ -457,6 +521,11 @@ static MHD_Result staticHandlerCallback(void* cls,
                                         size_t* upload_data_size,
                                         void** cont_cls);
 
+static void staticRequestCompletedCallback(void* cls,
+                                           struct MHD_Connection* connection,
+                                           void** cont_cls,
+                                           enum MHD_RequestTerminationCode toe);
+
 class InternalServer::CustomizedResources : public std::map<std::string, CustomizedResourceData>
 {
 public:
@@ -494,7 +563,8 @@ InternalServer::InternalServer(LibraryPtr library,
                                std::string indexTemplateString,
                                int ipConnectionLimit,
                                bool catalogOnlyMode,
-                               std::string contentServerUrl) :
+                               std::string contentServerUrl,
+                               int opdsStreamingThreshold) :
   m_addr(addr),
   m_port(port),
   m_root(root),
@@ -511,11 +581,17 @@ InternalServer::InternalServer(LibraryPtr library,
   mp_daemon(nullptr),
   mp_library(library),
   mp_nameMapper(nameMapper ? nameMapper : std::shared_ptr<NameMapper>(&defaultNameMapper, NoDelete())),
-  searchCache(getEnvVar<int>("KIWIX_SEARCH_CACHE_SIZE", DEFAULT_CACHE_SIZE)),
-  suggestionSearcherCache(getEnvVar<int>("KIWIX_SUGGESTION_SEARCHER_CACHE_SIZE", std::max((unsigned int) (mp_library->getBookCount(true, true)*0.1), 1U))),
+  searchCache(getEnvVar<int>("KIWIX_SEARCH_CACHE_SIZE", DEFAULT_CACHE_SIZE),
+              "InternalServer::searchCache"),
+  suggestionSearcherCache(getEnvVar<int>("KIWIX_SUGGESTION_SEARCHER_CACHE_SIZE", std::max((unsigned int) (mp_library->getBookCount(true, true)*0.1), 1U)),
+                          "InternalServer::suggestionSearcherCache"),
+  mp_opdsEntryCache(std::make_shared<OPDSEntryCache>(getEnvVar<int>("KIWIX_OPDS_ENTRY_CACHE_SIZE", DEFAULT_OPDS_ENTRY_CACHE_SIZE),
+                                                     "InternalServer::opdsEntryCache")),
+  mp_opdsRenderingPool(createOPDSRenderingPool()),
   m_customizedResources(new CustomizedResources),
   m_catalogOnlyMode(catalogOnlyMode),
-  m_contentServerUrl(contentServerUrl)
+  m_contentServerUrl(contentServerUrl),
+  m_opdsStreamingThreshold(opdsStreamingThreshold)
 {
   m_root = urlEncode(m_root);
 }
@@ -534,6 +610,7 @@ struct MHD_Daemon* InternalServer::startMHD(int flags,
                           MHD_OPTION_SOCK_ADDR, sockaddr,
                           MHD_OPTION_THREAD_POOL_SIZE, m_nbThreads,
                           MHD_OPTION_PER_IP_CONNECTION_LIMIT, m_ipConnectionLimit,
+                          MHD_OPTION_NOTIFY_COMPLETED, &staticRequestCompletedCallback, nullptr,
                           MHD_OPTION_END);
 }
 
@@ -570,6 +647,7 @@ void InternalServer::startMHD() {
 }
 
 bool InternalServer::start() {
+  precompileTemplates();
   try {
     startMHD();
   } catch (const std::runtime_error& err ) {
@@ -607,9 +685,85 @@ static MHD_Result staticHandlerCallback(void* cls,
                                 cont_cls);
 }
 
+typedef std::shared_ptr<CancellationToken> CancellationTokenPtr;
+
+// Called by MHD when it is done with a request, be it because the response
+// was sent or because the client has gone.
+static void staticRequestCompletedCallback(void* cls,
+                                           struct MHD_Connection* connection,
+                                           void** cont_cls,
+                                           enum MHD_RequestTerminationCode toe)
+{
+  auto token = static_cast<CancellationTokenPtr*>(*cont_cls);
+  if ( token == nullptr ) {
+    return;
+  }
+
+  if ( toe != MHD_REQUEST_TERMINATED_COMPLETED_OK ) {
+    (*token)->cancel();
+  }
+  // The token may outlive the connection (e.g. it is used by a response
+  // still being destroyed or by rendering threads) while the probe refers
+  // to the socket of the connection, which may be reused by MHD for
+  // another client.
+  (*token)->clearProbe();
+  delete token;
+  *cont_cls = nullptr;
+}
+
 namespace
 {
 
+#ifndef _WIN32
+// Tells if the client has closed the connection without consuming any data
+// pending on the socket. The probe runs while the request is handled, i.e.
+// once MHD has received the request: end of input then means that the client
+// has closed the connection (e.g. a browser leaving the page). A client that
+// only shut down its side of the connection can't be told apart from it at
+// the socket level and is considered gone as well.
+bool isPeerGone(int fd)
+{
+#ifdef POLLRDHUP
+  // Also detects the end of input when some data sent by the client is
+  // still unread
+  pollfd pfd{fd, POLLRDHUP, 0};
+  return poll(&pfd, 1, 0) > 0
+      && (pfd.revents & (POLLRDHUP | POLLHUP | POLLERR)) != 0;
+#else
+  char c;
+  const auto n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if ( n == 0 ) {
+    return true;
+  }
+  return n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+#endif
+}
+#endif
+
+// Attaches the cancellation token of the request to the MHD connection
+// so that it is cancelled if the client disconnects while the request
+// is being processed or the response is being streamed.
+void watchConnection(struct MHD_Connection* connection,
+                     void** cont_cls,
+                     const CancellationTokenPtr& token)
+{
+#ifndef _WIN32
+  const auto info = MHD_get_connection_info(connection, MHD_CONNECTION_INFO_CONNECTION_FD);
+  if ( info != nullptr ) {
+    const int fd = info->connect_fd;
+    token->setProbe([fd]() { return isPeerGone(fd); },
+                    std::chrono::milliseconds(20));
+  }
+#endif
+
+  auto holder = static_cast<CancellationTokenPtr*>(*cont_cls);
+  if ( holder == nullptr ) {
+    *cont_cls = new CancellationTokenPtr(token);
+  } else {
+    *holder = token;
+  }
+}
+
 MHD_Result add_name_value_pair(void *nvp, enum MHD_ValueKind kind,
                                const char *key, const char *value)
 {
@@ -629,6 +783,7 @@ MHD_Result InternalServer::handlerCallback(struct MHD_Connection* connection,
                                            void** cont_cls)
 {
   auto start_time = std::chrono::steady_clock::now();
+  KIWIX_TRACE2(request_start, fullUrl, method);
   if (m_verbose.load() ) {
     printf("======================\n");
     printf("Requesting : \n");
@@ -644,6 +799,7 @@ MHD_Result InternalServer::handlerCallback(struct MHD_Connection* connection,
                           : -1;
 
   RequestContext request(fullUrl, rootPrefixLen, method, version, headers, queryArgs);
+  watchConnection(connection, cont_cls, request.get_cancellation_token());
 
   if (m_verbose.load() ) {
     request.print_debug_info();
@@ -654,10 +810,21 @@ MHD_Result InternalServer::handlerCallback(struct MHD_Connection* connection,
    && request.get_method() != RequestMethod::HEAD) {
     printf("Reject request because of unhandled request method.\n");
     printf("----------------------\n");
+    KIWIX_TRACE2(request_end, fullUrl, 0);
     return MHD_NO;
   }
 
-  auto response = handle_request(request);
+  std::unique_ptr<Response> response;
+  try {
+    response = handle_request(request);
+  } catch (const OperationCancelled&) {
+    if (m_verbose.load()) {
+      printf("Request cancelled (client disconnected)\n");
+      printf("----------------------\n");
+    }
+    KIWIX_TRACE2(request_end, fullUrl, 0);
+    return MHD_NO;
+  }
 
   if (response->getReturnCode() == MHD_HTTP_INTERNAL_SERVER_ERROR) {
     printf("========== INTERNAL ERROR !! ============\n");
@@ -673,6 +840,7 @@ MHD_Result InternalServer::handlerCallback(struct MHD_Connection* connection,
   }
 
   auto ret = response->send(request, m_verbose.load(), connection);
+  KIWIX_TRACE2(request_end, fullUrl, response->getReturnCode());
   auto end_time = std::chrono::steady_clock::now();
   auto time_span = std::chrono::duration_cast<std::chrono::duration<double>>(end_time - start_time);
   if (m_verbose.load()) {
@@ -752,9 +920,14 @@ std::unique_ptr<Response> InternalServer::handle_request(const RequestContext& r
     if (isEndpointUrl(url, "catch"))
       return handle_catch(request);
 
+    if (url == "/stats/locks" && isLockInstrumentationEnabled())
+      return handle_lock_stats(request);
+
     const std::string contentUrl = m_root + "/content" + urlEncode(url);
     const std::string query = getSearchComponent(request);
     return Response::build_redirect(contentUrl + query);
+  } catch (const OperationCancelled&) {
+    throw;
   } catch (std::exception& e) {
     fprintf(stderr, "===== Unhandled error : %s\n", e.what());
     return HTTP500Response(request, m_root, request.get_full_url(), e.what());
@@ -790,6 +963,9 @@ class InternalServer::LockableSuggestionSearcher : public zim::SuggestionSearche
     std::unique_lock<std::mutex> getLock() {
       return std::unique_lock<std::mutex>(m_mutex);
     }
+    std::unique_lock<std::mutex> getLock(std::defer_lock_t) {
+      return std::unique_lock<std::mutex>(m_mutex, std::defer_lock);
+    }
     virtual ~LockableSuggestionSearcher() = default;
   private:
     std::mutex m_mutex;
@@ -837,7 +1013,9 @@ std::unique_ptr<Response> InternalServer::handle_suggest(const RequestContext& r
   auto searcher = suggestionSearcherCache.getOrPut(bookId,
     [=](){ return make_shared<LockableSuggestionSearcher>(*archive); }
   );
-  const auto lock(searcher->getLock());
+  static LockCounters& lockCounters = getLockCounters("LockableSuggestionSearcher");
+  auto searcherLock(searcher->getLock(std::defer_lock));
+  const InstrumentedLock<std::unique_lock<std::mutex>> lock(searcherLock, lockCounters);
   auto search = searcher->suggest(queryString);
   auto srs = search.getResults(start, count);
 
@@ -854,6 +1032,31 @@ std::unique_ptr<Response> InternalServer::handle_suggest(const RequestContext& r
   return ContentResponse::build(results.getJSON(), "application/json; charset=utf-8");
 }
 
+std::unique_ptr<Response> InternalServer::handle_lock_stats(const RequestContext& request)
+{
+  if (m_verbose.load()) {
+    printf("** running handle_lock_stats\n");
+  }
+
+  std::ostringstream oss;
+  oss << "[";
+  const char* sep = "\n";
+  for (const auto& stats : getLockStatistics()) {
+    oss << sep << "  {"
+        << "\"name\": \"" << escapeForJSON(stats.name) << "\", "
+        << "\"acquisitions\": " << stats.acquisitions << ", "
+        << "\"contentions\": " << stats.contentions << ", "
+        << "\"total_wait_ns\": " << stats.totalWaitNs << ", "
+        << "\"max_wait_ns\": " << stats.maxWaitNs << ", "
+        << "\"total_hold_ns\": " << stats.totalHoldNs << ", "
+        << "\"max_hold_ns\": " << stats.maxHoldNs
+        << "}";
+    sep = ",\n";
+  }
+  oss << "\n]\n";
+  return ContentResponse::build(oss.str(), "application/json; charset=utf-8");
+}
+
 std::unique_ptr<Response> InternalServer::handle_viewer_settings(const RequestContext& request)
 {
   if (m_verbose.load()) {
@@ -870,11 +1073,11 @@ std::unique_ptr<Response> InternalServer::handle_viewer_settings(const RequestCo
 
 std::string InternalServer::getNoJSDownloadPageHTML(const std::string& bookId, const std::string& userLang) const
 {
-  const auto book = mp_library->getBookById(bookId);
-  auto bookUrl = kiwix::stripSuffix(book.getUrl(), ".meta4");
+  const auto book = mp_library->getBookPtrById(bookId);
+  auto bookUrl = kiwix::stripSuffix(book->getUrl(), ".meta4");
   auto getTranslation = i18n::GetTranslatedStringWithMsgId(userLang);
   const auto translations = kainjow::mustache::object{
-                            getTranslation("download-links-heading", {{"BOOK_TITLE", book.getTitle()}}),
+                            getTranslation("download-links-heading", {{"BOOK_TITLE", book->getTitle()}}),
                             getTranslation("download-links-title"),
                             getTranslation("direct-download-link-text"),
                             getTranslation("hash-download-link-text"),
@@ -910,10 +1113,16 @@ std::unique_ptr<Response> InternalServer::handle_no_js(const RequestContext& req
   setContentAccessUrl(htmlDumper);
   auto userLang = request.get_user_language();
   htmlDumper.setUserLanguage(userLang);
+  htmlDumper.setCancellationToken(request.get_cancellation_token());
   std::string content;
 
   if (urlParts.size() == 1) {
-    auto filter = get_search_filter(request, "", m_catalogOnlyMode);
+    Filter filter;
+    try {
+      filter = get_search_filter(request, "", m_catalogOnlyMode);
+    } catch (const std::invalid_argument&) {
+      return HTTP400Response(request);
+    }
     try {
       if (request.get_argument("category") == "") {
         filter.clearCategory();
@@ -924,7 +1133,13 @@ std::unique_ptr<Response> InternalServer::handle_no_js(const RequestContext& req
         filter.clearLang();
       }
     } catch (...) {}
-    content = htmlDumper.dumpPlainHTML(filter);
+    supportedListSortBy sortBy = UNSORTED;
+    bool ascending = true;
+    const auto sort = request.get_optional_param<std::string>("sort", "");
+    if ( !sort.empty() && !parseSortParam(sort, sortBy, ascending) ) {
+      return HTTP400Response(request);
+    }
+    content = htmlDumper.dumpPlainHTML(filter, sortBy, ascending);
   } else if ((urlParts.size() == 3) && (urlParts[1] == "download")) {
     try {
       const auto bookId = mp_nameMapper->getIdForName(urlParts[2]);
@@ -1004,6 +1219,9 @@ std::unique_ptr<Response> InternalServer::handle_search(const RequestContext& re
   } catch (const Error& e) {
     return HTTP400Response(request)
       + e.message();
+  } catch (const std::invalid_argument&) {
+    // invalid value of a books.filter.* parameter
+    return HTTP400Response(request);
   }
 }
 
@@ -1031,9 +1249,12 @@ std::unique_ptr<Response> InternalServer::handle_search_request(const RequestCon
   /* Make the search */
   // Try to get a search from the searchInfo, else build it
   auto searcher = mp_library->getSearcherByIds(bookIds);
-  auto lock(searcher->getLock());
+  static LockCounters& lockCounters = getLockCounters("ZimSearcher::m_mutex");
+  auto searcherLock(searcher->getLock(std::defer_lock));
+  const InstrumentedLock<std::unique_lock<std::mutex>> lock(searcherLock, lockCounters);
 
   std::shared_ptr<zim::Search> search;
+  KIWIX_TRACE2(search_start, searchInfo.pattern.c_str(), bookIds.size());
   try {
     search = searchCache.getOrPut(searchInfo,
       [=](){
@@ -1041,6 +1262,7 @@ std::unique_ptr<Response> InternalServer::handle_search_request(const RequestCon
       }
     );
   } catch(std::runtime_error& e) {
+    KIWIX_TRACE2(search_end, searchInfo.pattern.c_str(), -1);
     // Searcher->search will throw a runtime error if there is no valid xapian database to do the search.
     // (in case of zim file not containing a index)
     const auto cssUrl = renderUrl(m_root, RESOURCE::templates::url_of_search_results_css_tmpl);
@@ -1066,8 +1288,13 @@ std::unique_ptr<Response> InternalServer::handle_search_request(const RequestCon
   const auto pageLength = getSearchPageSize(request);
 
   /* Get the results */
-  SearchRenderer renderer(search->getResults(start, pageLength), start,
-                          search->getEstimatedMatches());
+  const auto cancellationToken = request.get_cancellation_token();
+  cancellationToken->throwIfCancelled();
+  auto results = search->getResults(start, pageLength);
+  cancellationToken->throwIfCancelled();
+  const auto estimatedMatches = search->getEstimatedMatches();
+  KIWIX_TRACE2(search_end, searchInfo.pattern.c_str(), estimatedMatches);
+  SearchRenderer renderer(results, start, estimatedMatches);
   renderer.setSearchPattern(searchInfo.pattern);
   renderer.setSearchBookQuery(searchInfo.bookFilterQuery);
   renderer.setProtocolPrefix(m_root + "/content/");
@@ -1159,17 +1386,37 @@ std::unique_ptr<Response> InternalServer::handle_catch(const RequestContext& req
 
 std::vector<std::string>
 InternalServer::search_catalog(const RequestContext& request,
-                               kiwix::OPDSDumper& opdsDumper)
+                               kiwix::LibraryDumper& libraryDumper)
 {
     const auto filter = get_search_filter(request, "", m_catalogOnlyMode);
-    std::vector<std::string> bookIdsToDump = mp_library->filter(filter);
-    const auto totalResults = bookIdsToDump.size();
     const long count = request.get_optional_param("count", 10L);
+    const size_t intendedCount = count >= 0 ? count : std::numeric_limits<size_t>::max();
     const size_t startIndex = request.get_optional_param("start", 0UL);
-    const size_t intendedCount = count >= 0 ? count : bookIdsToDump.size();
-    bookIdsToDump = subrange(bookIdsToDump, startIndex, intendedCount);
-    opdsDumper.setOpenSearchInfo(totalResults, startIndex, bookIdsToDump.size());
-    return bookIdsToDump;
+    const auto cursor = request.get_optional_param<std::string>("cursor", "");
+    const auto sort = request.get_optional_param<std::string>("sort", "");
+    supportedListSortBy sortBy;
+    bool ascending;
+    Library::BookIdPage page;
+    if ( !cursor.empty() ) {
+      // A cursor locates a page of the results in the default order only
+      if ( !sort.empty() ) {
+        throw std::invalid_argument("The cursor and sort parameters can't be combined");
+      }
+      // Throws std::invalid_argument if the cursor is malformed
+      page = mp_library->filterPageAfter(filter, cursor, intendedCount);
+    } else if ( !sort.empty() ) {
+      if ( !parseSortParam(sort, sortBy, ascending) ) {
+        throw std::invalid_argument("Invalid sort parameter: " + sort);
+      }
+      page = mp_library->filterPage(filter, startIndex, intendedCount, sortBy, ascending);
+    } else {
+      page = mp_library->filterPage(filter, startIndex, intendedCount);
+    }
+    request.get_cancellation_token()->throwIfCancelled();
+    libraryDumper.setOpenSearchInfo(page.totalCount, page.startIndex, page.bookIds.size());
+    libraryDumper.setNextCursor(page.nextCursor);
+    libraryDumper.setCancellationToken(request.get_cancellation_token());
+    return page.bookIds;
 }
 
 namespace
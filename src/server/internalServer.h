@@ -90,6 +90,9 @@ class SearchInfo {
 
 typedef kainjow::mustache::data MustacheData;
 class OPDSDumper;
+class JSONDumper;
+class OPDSEntryCache;
+class WorkerPool;
 class LibraryDumper;
 
 class InternalServer {
@@ -109,7 +112,8 @@ class InternalServer {
                    std::string indexTemplateString,
                    int ipConnectionLimit,
                    bool catalogOnlyMode,
-                   std::string zimViewerURL);
+                   std::string zimViewerURL,
+                   int opdsStreamingThreshold);
     virtual ~InternalServer();
 
     MHD_Result handlerCallback(struct MHD_Connection* connection,
@@ -151,9 +155,11 @@ class InternalServer {
     std::unique_ptr<Response> handle_content(const RequestContext& request);
     std::unique_ptr<Response> handle_raw(const RequestContext& request);
     std::unique_ptr<Response> handle_locally_customized_resource(const RequestContext& request);
+    std::unique_ptr<Response> handle_lock_stats(const RequestContext& request);
 
+    // Throws std::invalid_argument if the paging or sorting parameters are invalid
     std::vector<std::string> search_catalog(const RequestContext& request,
-                                            kiwix::OPDSDumper& opdsDumper);
+                                            kiwix::LibraryDumper& libraryDumper);
 
     MustacheData get_default_data() const;
 
@@ -166,6 +172,11 @@ class InternalServer {
 
     std::string getNoJSDownloadPageHTML(const std::string& bookId, const std::string& userLang) const;
     OPDSDumper getOPDSDumper() const;
+    JSONDumper getJSONDumper() const;
+    std::unique_ptr<Response> buildOPDSFeedStreamingResponse(const OPDSDumper& opdsDumper,
+                                                             std::string feedHeader,
+                                                             std::vector<std::string> bookIds,
+                                                             bool partial) const;
     void setContentAccessUrl(LibraryDumper& libDumper) const;
 
   private: // types
@@ -194,6 +205,8 @@ class InternalServer {
 
     SearchCache searchCache;
     SuggestionSearcherCache suggestionSearcherCache;
+    std::shared_ptr<OPDSEntryCache> mp_opdsEntryCache;
+    std::shared_ptr<WorkerPool> mp_opdsRenderingPool;
 
     std::string m_server_id;
 
@@ -202,6 +215,7 @@ class InternalServer {
 
     const bool m_catalogOnlyMode;
     const std::string m_contentServerUrl;
+    const int m_opdsStreamingThreshold;
 };
 
 }
@@ -21,6 +21,7 @@
 
 #include "library.h"
 #include "opds_dumper.h"
+#include "json_dumper.h"
 #include "request_context.h"
 #include "response.h"
 #include "tools/otherTools.h"
@@ -28,6 +29,7 @@
 
 #include <mustache.hpp>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -49,6 +51,79 @@ const std::string opdsMimeType[] = {
   "application/atom+xml;profile=opds-catalog;kind=acquisition;charset=utf-8"
 };
 
+// Number of entries rendered at once when streaming a feed (large enough
+// for the rendering of a batch to be spread over several threads)
+const size_t OPDS_STREAMING_BATCH_SIZE = 512;
+
+// Feeds with at least threshold entries are streamed (a negative threshold
+// disables streaming).
+bool shouldStreamOPDSFeed(size_t entryCount, int threshold)
+{
+  return threshold >= 0 && entryCount >= size_t(threshold);
+}
+
+// Produces an OPDS acquisition feed piece by piece (for a StreamingResponse)
+// from a snapshot of the ids of the books in it. Books removed from the
+// library while the feed is being sent are skipped.
+class OPDSFeedGenerator
+{
+public: // functions
+  OPDSFeedGenerator(ConstLibraryPtr library,
+                    std::shared_ptr<const NameMapper> nameMapper,
+                    const OPDSDumper& dumper,
+                    std::string feedHeader,
+                    std::vector<std::string> bookIds,
+                    bool partial)
+    : mp_library(library)
+    , mp_nameMapper(nameMapper)
+    , m_dumper(dumper)
+    , m_pendingData(std::move(feedHeader))
+    , m_bookIds(std::move(bookIds))
+    , m_partial(partial)
+  {}
+
+  bool operator()(std::string& piece)
+  {
+    piece.swap(m_pendingData);
+    m_pendingData.clear();
+
+    const size_t batchEnd = std::min(m_nextBook + OPDS_STREAMING_BATCH_SIZE,
+                                     m_bookIds.size());
+    const std::vector<std::string> batch(m_bookIds.begin() + m_nextBook,
+                                         m_bookIds.begin() + batchEnd);
+    m_nextBook = batchEnd;
+    piece += m_dumper.dumpOPDSEntries(batch, m_partial);
+
+    if ( m_nextBook < m_bookIds.size() ) {
+      return true;
+    }
+    piece += OPDSDumper::dumpOPDSFeedFooter();
+    return false;
+  }
+
+private: // data
+  // The dumper refers to these objects, which must stay alive until
+  // the end of the response.
+  ConstLibraryPtr mp_library;
+  std::shared_ptr<const NameMapper> mp_nameMapper;
+
+  OPDSDumper m_dumper;
+  std::string m_pendingData;
+  std::vector<std::string> m_bookIds;
+  size_t m_nextBook = 0;
+  bool m_partial;
+};
+
+const char JSON_MIME_TYPE[] = "application/json; charset=utf-8";
+
+// The /catalog/v2 endpoints returning lists of books, a single book, the
+// categories or the languages produce JSON instead of OPDS if the request
+// has the format=json parameter.
+bool isJSONRequested(const RequestContext& request)
+{
+  return request.get_requested_format() == "json";
+}
+
 } // unnamed namespace
 
 OPDSDumper InternalServer::getOPDSDumper() const
@@ -57,9 +132,20 @@ OPDSDumper InternalServer::getOPDSDumper() const
   opdsDumper.setRootLocation(m_root);
   opdsDumper.setLibraryId(getLibraryId());
   setContentAccessUrl(opdsDumper);
+  opdsDumper.setEntryCache(mp_opdsEntryCache);
+  opdsDumper.setRenderingPool(mp_opdsRenderingPool);
   return opdsDumper;
 }
 
+JSONDumper InternalServer::getJSONDumper() const
+{
+  kiwix::JSONDumper jsonDumper(mp_library.get(), mp_nameMapper.get());
+  jsonDumper.setRootLocation(m_root);
+  jsonDumper.setLibraryId(getLibraryId());
+  setContentAccessUrl(jsonDumper);
+  return jsonDumper;
+}
+
 std::unique_ptr<Response> InternalServer::handle_catalog(const RequestContext& request)
 {
   if (m_verbose.load()) {
@@ -95,16 +181,39 @@ std::unique_ptr<Response> InternalServer::handle_catalog(const RequestContext& r
     uuid = zim::Uuid::generate(host);
     bookIdsToDump = mp_library->filter(kiwix::Filter().valid(true).local(true).remote(true));
   } else if (url == "search") {
-    bookIdsToDump = search_catalog(request, opdsDumper);
+    try {
+      bookIdsToDump = search_catalog(request, opdsDumper);
+    } catch (const std::invalid_argument&) {
+      return HTTP400Response(request);
+    }
     uuid = zim::Uuid::generate();
   }
 
+  if (shouldStreamOPDSFeed(bookIdsToDump.size(), m_opdsStreamingThreshold)) {
+    return buildOPDSFeedStreamingResponse(opdsDumper,
+                                          opdsDumper.dumpOPDSFeedHeader(request.get_query()),
+                                          std::move(bookIdsToDump),
+                                          /*partial=*/false);
+  }
+
   auto response = ContentResponse::build(
       opdsDumper.dumpOPDSFeed(bookIdsToDump, request.get_query()),
       opdsMimeType[OPDS_ACQUISITION_FEED]);
   return std::move(response);
 }
 
+std::unique_ptr<Response> InternalServer::buildOPDSFeedStreamingResponse(const OPDSDumper& opdsDumper,
+                                                                         std::string feedHeader,
+                                                                         std::vector<std::string> bookIds,
+                                                                         bool partial) const
+{
+  OPDSFeedGenerator generator(mp_library, mp_nameMapper, opdsDumper,
+                              std::move(feedHeader), std::move(bookIds),
+                              partial);
+  return std::make_unique<StreamingResponse>(std::move(generator),
+                                             opdsMimeType[OPDS_ACQUISITION_FEED]);
+}
+
 std::unique_ptr<Response> InternalServer::handle_catalog_v2(const RequestContext& request)
 {
   if (m_verbose.load()) {
@@ -165,8 +274,32 @@ std::unique_ptr<Response> InternalServer::handle_catalog_v2_root(const RequestCo
 
 std::unique_ptr<Response> InternalServer::handle_catalog_v2_entries(const RequestContext& request, bool partial)
 {
+  if (isJSONRequested(request)) {
+    kiwix::JSONDumper jsonDumper = getJSONDumper();
+    std::vector<std::string> bookIds;
+    try {
+      bookIds = search_catalog(request, jsonDumper);
+    } catch (const std::invalid_argument&) {
+      return HTTP400Response(request);
+    }
+    return ContentResponse::build(jsonDumper.dumpEntries(bookIds, partial),
+                                  JSON_MIME_TYPE);
+  }
+
   kiwix::OPDSDumper opdsDumper = getOPDSDumper();
-  const auto bookIds = search_catalog(request, opdsDumper);
+  std::vector<std::string> bookIds;
+  try {
+    bookIds = search_catalog(request, opdsDumper);
+  } catch (const std::invalid_argument&) {
+    return HTTP400Response(request);
+  }
+  if (shouldStreamOPDSFeed(bookIds.size(), m_opdsStreamingThreshold)) {
+    return buildOPDSFeedStreamingResponse(opdsDumper,
+                                          opdsDumper.dumpOPDSFeedV2Header(request.get_query(), partial),
+                                          std::move(bookIds),
+                                          partial);
+  }
+
   const auto opdsFeed = opdsDumper.dumpOPDSFeedV2(bookIds, request.get_query(), partial);
   return ContentResponse::build(
              opdsFeed,
@@ -177,11 +310,16 @@ std::unique_ptr<Response> InternalServer::handle_catalog_v2_entries(const Reques
 std::unique_ptr<Response> InternalServer::handle_catalog_v2_complete_entry(const RequestContext& request, const std::string& entryId)
 {
   try {
-    mp_library->getBookById(entryId);
+    mp_library->getBookPtrById(entryId);
   } catch (const std::out_of_range&) {
     return UrlNotFoundResponse(request);
   }
 
+  if (isJSONRequested(request)) {
+    return ContentResponse::build(getJSONDumper().dumpEntry(entryId),
+                                  JSON_MIME_TYPE);
+  }
+
   kiwix::OPDSDumper opdsDumper = getOPDSDumper();
   const auto opdsFeed = opdsDumper.dumpOPDSCompleteEntry(entryId);
   return ContentResponse::build(
@@ -192,6 +330,11 @@ std::unique_ptr<Response> InternalServer::handle_catalog_v2_complete_entry(const
 
 std::unique_ptr<Response> InternalServer::handle_catalog_v2_categories(const RequestContext& request)
 {
+  if (isJSONRequested(request)) {
+    return ContentResponse::build(getJSONDumper().dumpCategories(),
+                                  JSON_MIME_TYPE);
+  }
+
   kiwix::OPDSDumper opdsDumper = getOPDSDumper();
   return ContentResponse::build(
              opdsDumper.categoriesOPDSFeed(),
@@ -201,6 +344,11 @@ std::unique_ptr<Response> InternalServer::handle_catalog_v2_categories(const Req
 
 std::unique_ptr<Response> InternalServer::handle_catalog_v2_languages(const RequestContext& request)
 {
+  if (isJSONRequested(request)) {
+    return ContentResponse::build(getJSONDumper().dumpLanguages(),
+                                  JSON_MIME_TYPE);
+  }
+
   kiwix::OPDSDumper opdsDumper = getOPDSDumper();
   return ContentResponse::build(
              opdsDumper.languagesOPDSFeed(),
@@ -212,9 +360,9 @@ std::unique_ptr<Response> InternalServer::handle_catalog_v2_illustration(const R
 {
   try {
     const auto bookId  = request.get_url_part(3);
-    auto book = mp_library->getBookByIdThreadSafe(bookId);
+    const auto book = mp_library->getBookPtrById(bookId);
     auto size = request.get_argument<unsigned int>("size");
-    auto illustration = book.getIllustration(size);
+    auto illustration = book->getIllustration(size);
     return ContentResponse::build(
                illustration->getData(),
                illustration->mimeType
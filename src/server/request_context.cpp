@@ -28,12 +28,18 @@
 #include <cctype>
 
 #include "tools/stringTools.h"
+#include "tools/concurrent_cache.h"
 #include "i18n_utils.h"
 
 namespace kiwix {
 
 static std::atomic_ullong s_requestIndex(0);
 
+// Browsers send only a handful of distinct Accept-Language values, so the
+// language selected for each of them is memoized.
+static ConcurrentCache<std::string, std::string> acceptLanguageCache(
+    64, "RequestContext::acceptLanguageCache");
+
 namespace {
 
 RequestMethod str2RequestMethod(const std::string& method) {
@@ -63,7 +69,9 @@ RequestContext::RequestContext(const std::string& _fullUrl,   // URI-decoded
   version(version),
   requestIndex(s_requestIndex++),
   acceptEncodingGzip(false),
-  byteRange_()
+  byteRange_(),
+  userlangDetermined(false),
+  cancellationToken(std::make_shared<CancellationToken>())
 {
   for ( const auto& kv : headers ) {
     add_header(kv.first, kv.second);
@@ -81,8 +89,6 @@ RequestContext::RequestContext(const std::string& _fullUrl,   // URI-decoded
   try {
     byteRange_ = ByteRange::parse(get_header(MHD_HTTP_HEADER_RANGE));
   } catch (const std::out_of_range&) {}
-
-  userlang = determine_user_language();
 }
 
 RequestContext::~RequestContext()
@@ -195,6 +201,10 @@ std::string RequestContext::get_header(const std::string& name) const {
 
 std::string RequestContext::get_user_language() const
 {
+  if ( !userlangDetermined ) {
+    userlang = determine_user_language();
+    userlangDetermined = true;
+  }
   return userlang.lang;
 }
 
@@ -206,8 +216,10 @@ RequestContext::UserLanguage RequestContext::determine_user_language() const
 
   try {
     const std::string acceptLanguage = get_header("Accept-Language");
-    const auto userLangPrefs = parseUserLanguagePreferences(acceptLanguage);
-    const auto lang = selectMostSuitableLanguage(userLangPrefs);
+    const auto lang = acceptLanguageCache.getOrPut(acceptLanguage, [&]() {
+      const auto userLangPrefs = parseUserLanguagePreferences(acceptLanguage);
+      return selectMostSuitableLanguage(userLangPrefs);
+    });
     return {UserLanguage::SelectorKind::ACCEPT_LANGUAGE_HEADER, lang};
   } catch(const std::out_of_range&) {}
 
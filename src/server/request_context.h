@@ -25,11 +25,13 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <memory>
 #include <vector>
 #include <stdexcept>
 
 #include "byte_range.h"
 #include "../tools/stringTools.h"
+#include "../tools/cancellation_token.h"
 
 extern "C" {
 #include "microhttpd_wrapper.h"
@@ -123,6 +125,10 @@ class RequestContext {
     std::string get_user_language() const;
     std::string get_requested_format() const;
 
+    // The token is cancelled when the client is gone (or the request is
+    // otherwise aborted) so that the work done for it can be stopped early.
+    std::shared_ptr<CancellationToken> get_cancellation_token() const { return cancellationToken; }
+
   private: // types
     struct UserLanguage
     {
@@ -150,7 +156,10 @@ class RequestContext {
     std::map<std::string, std::string> headers;
     std::map<std::string, std::vector<std::string>> arguments;
     std::string queryString;
-    UserLanguage userlang;
+    // Determined lazily by get_user_language()
+    mutable bool userlangDetermined;
+    mutable UserLanguage userlang;
+    std::shared_ptr<CancellationToken> cancellationToken;
 
   private: // functions
     UserLanguage determine_user_language() const;
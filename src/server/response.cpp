@@ -26,6 +26,8 @@
 #include "tools/stringTools.h"
 #include "tools/otherTools.h"
 #include "tools/archiveTools.h"
+#include "tools/tracepoints.h"
+#include "tools/lrucache.h"
 
 #include "string.h"
 #include <mustache.hpp>
@@ -34,6 +36,7 @@
 #include <array>
 #include <list>
 #include <map>
+#include <mutex>
 #include <regex>
 
 // This is somehow a magic value.
@@ -112,6 +115,102 @@ bool compress(std::string &content) {
   return true;
 }
 
+// Incremental counterpart of compress()
+class GzipCompressor
+{
+public:
+  GzipCompressor()
+  {
+    m_strm.zalloc = Z_NULL;
+    m_strm.zfree = Z_NULL;
+    m_strm.opaque = Z_NULL;
+    const auto ret = deflateInit2(&m_strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                  31, 8, Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK) {
+      throw std::runtime_error("Cannot initialize gzip compression");
+    }
+  }
+
+  GzipCompressor(const GzipCompressor&) = delete;
+  GzipCompressor& operator=(const GzipCompressor&) = delete;
+
+  ~GzipCompressor() { deflateEnd(&m_strm); }
+
+  // Compresses the next piece of data appending the result to output
+  // (which may be left unchanged since the compressed data is buffered).
+  // finish must be true for the last piece of data.
+  void compress(const std::string& input, bool finish, std::string& output)
+  {
+    m_strm.avail_in = static_cast<decltype(m_strm.avail_in)>(input.size());
+    m_strm.next_in =
+        const_cast<Bytef *>(reinterpret_cast<const Bytef *>(input.data()));
+
+    std::array<char, 16384> buff{};
+    int ret;
+    do {
+      m_strm.avail_out = buff.size();
+      m_strm.next_out = reinterpret_cast<Bytef *>(buff.data());
+      ret = deflate(&m_strm, finish ? Z_FINISH : Z_NO_FLUSH);
+      assert(ret != Z_STREAM_ERROR);
+      output.append(buff.data(), buff.size() - m_strm.avail_out);
+    } while (m_strm.avail_out == 0);
+
+    assert(m_strm.avail_in == 0);
+    assert(!finish || ret == Z_STREAM_END);
+  }
+
+private: // data
+  z_stream m_strm;
+};
+
+
+// Sizes of the compressed versions of the ZIM items sent so far, so that
+// HEAD requests can be answered without compressing the item again.
+class CompressedSizeCache
+{
+public:
+  explicit CompressedSizeCache(size_t maxEntries)
+    : m_impl(maxEntries)
+  {}
+
+  bool get(const std::string& key, size_t& size)
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    const auto r = m_impl.get(key);
+    if ( r.miss() ) {
+      return false;
+    }
+    size = r.value();
+    return true;
+  }
+
+  void put(const std::string& key, size_t size)
+  {
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_impl.put(key, size);
+  }
+
+private: // data
+  std::mutex m_mutex;
+  lru_cache<std::string, size_t> m_impl;
+};
+
+CompressedSizeCache& getCompressedSizeCache()
+{
+  static CompressedSizeCache cache(
+    std::max(getEnvVar<int>("KIWIX_COMPRESSED_SIZE_CACHE_SIZE", 10000), 1));
+  return cache;
+}
+
+std::string getZimItemKey(const zim::Item& item)
+{
+  return kiwix::to_string(item.getIndex());
+}
+
+std::string getCompressedSizeKey(const ETag& etag, const std::string& zimItemKey)
+{
+  return etag.get_body() + "/" + zimItemKey;
+}
 
 const char* getCacheControlHeader(Response::Kind k)
 {
@@ -548,11 +647,14 @@ static MHD_Result print_key_value (void *cls, enum MHD_ValueKind kind,
 struct RunningResponse {
    zim::Item item;
    int range_start;
+   std::shared_ptr<const CancellationToken> cancellationToken;
 
    RunningResponse(zim::Item item,
-                   int range_start) :
+                   int range_start,
+                   std::shared_ptr<const CancellationToken> cancellationToken) :
      item(item),
-     range_start(range_start)
+     range_start(range_start),
+     cancellationToken(cancellationToken)
    {}
 };
 
@@ -567,10 +669,11 @@ static ssize_t callback_reader_from_item(void* cls,
     max,
     response->item.getSize() - pos - response->range_start);
 
-  if (max_size_to_set <= 0) {
+  if (max_size_to_set <= 0 || response->cancellationToken->isCancelled()) {
     return MHD_CONTENT_READER_END_WITH_ERROR;
   }
 
+  KIWIX_TRACE2(item_read, response->range_start+pos, max_size_to_set);
   zim::Blob blob = response->item.getData(response->range_start+pos, max_size_to_set);
   memcpy(buf, blob.data(), max_size_to_set);
   return max_size_to_set;
@@ -582,6 +685,85 @@ static void callback_free_response(void* cls)
   delete response;
 }
 
+struct RunningStreamingResponse {
+   StreamingResponse::ContentGenerator generator;
+   std::shared_ptr<const CancellationToken> cancellationToken;
+   std::unique_ptr<GzipCompressor> compressor; // null if not compressing
+   std::string buffer; // (possibly compressed) content not sent yet
+   size_t bufferPos = 0;
+   bool lastPieceGenerated = false;
+
+   RunningStreamingResponse(StreamingResponse::ContentGenerator generator,
+                            std::shared_ptr<const CancellationToken> cancellationToken,
+                            bool compress) :
+     generator(std::move(generator)),
+     cancellationToken(cancellationToken),
+     compressor(compress ? new GzipCompressor : nullptr)
+   {}
+
+   // Returns false if there is nothing more to send
+   bool fillBuffer()
+   {
+     while ( bufferPos == buffer.size() ) {
+       if ( lastPieceGenerated ) {
+         return false;
+       }
+       buffer.clear();
+       bufferPos = 0;
+       std::string piece;
+       lastPieceGenerated = !generator(piece);
+       if ( compressor ) {
+         compressor->compress(piece, lastPieceGenerated, buffer);
+       } else {
+         buffer.swap(piece);
+       }
+     }
+     return true;
+   }
+};
+
+static ssize_t callback_reader_from_generator(void* cls,
+                                              uint64_t pos,
+                                              char* buf,
+                                              size_t max)
+{
+  RunningStreamingResponse* response = static_cast<RunningStreamingResponse*>(cls);
+
+  if (response->cancellationToken->isCancelled()) {
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+  }
+
+  try {
+    if (!response->fillBuffer()) {
+      return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+  } catch (...) {
+    // Headers are already sent, the only option left is to abort the
+    // transfer (which includes the case of a cancelled request).
+    return MHD_CONTENT_READER_END_WITH_ERROR;
+  }
+
+  const size_t size = std::min(max, response->buffer.size() - response->bufferPos);
+  memcpy(buf, response->buffer.data() + response->bufferPos, size);
+  response->bufferPos += size;
+  return size;
+}
+
+static void callback_free_streaming_response(void* cls)
+{
+  RunningStreamingResponse* response = static_cast<RunningStreamingResponse*>(cls);
+  delete response;
+}
+
+static ssize_t callback_reader_no_body(void* cls,
+                                       uint64_t pos,
+                                       char* buf,
+                                       size_t max)
+{
+  // Never called since the body of a response to a HEAD request isn't sent
+  return MHD_CONTENT_READER_END_WITH_ERROR;
+}
+
 
 
 void print_response_info(int retCode, MHD_Response* response)
@@ -617,6 +799,10 @@ ContentResponse::create_mhd_response(const RequestContext& request)
     m_content.size(), const_cast<char*>(m_content.data()), MHD_RESPMEM_MUST_COPY);
 
   if (isCompressed) {
+    if ( !m_zimItemKey.empty() && m_etag ) {
+      getCompressedSizeCache().put(getCompressedSizeKey(m_etag, m_zimItemKey),
+                                   m_content.size());
+    }
     m_etag.set_option(ETag::COMPRESSED_CONTENT);
     MHD_add_response_header(
         response, MHD_HTTP_HEADER_VARY, "Accept-Encoding");
@@ -690,10 +876,14 @@ std::unique_ptr<Response> ItemResponse::build(const RequestContext& request, con
   auto byteRange = request.get_range().resolve(item.getSize());
   const bool noRange = byteRange.kind() == ByteRange::RESOLVED_FULL_CONTENT;
   if (noRange && is_compressible_mime_type(mimetype)) {
+    if (request.get_method() == RequestMethod::HEAD) {
+      return std::make_unique<ItemHeadResponse>(item, mimetype);
+    }
     // Return a contentResponse
     auto response = ContentResponse::build(item.getData(), mimetype);
     response->set_kind(Response::ZIM_CONTENT);
     response->m_byteRange = byteRange;
+    response->m_zimItemKey = getZimItemKey(item);
     return std::move(response);
   }
 
@@ -713,7 +903,7 @@ ItemResponse::create_mhd_response(const RequestContext& request)
   MHD_Response* response = MHD_create_response_from_callback(content_length,
                                                16384,
                                                callback_reader_from_item,
-                                               new RunningResponse(m_item, m_byteRange.first()),
+                                               new RunningResponse(m_item, m_byteRange.first(), request.get_cancellation_token()),
                                                callback_free_response);
   MHD_add_response_header(response, MHD_HTTP_HEADER_ACCEPT_RANGES, "bytes");
   if ( m_byteRange.kind() == ByteRange::RESOLVED_PARTIAL_CONTENT ) {
@@ -730,5 +920,80 @@ ItemResponse::create_mhd_response(const RequestContext& request)
   return response;
 }
 
+ItemHeadResponse::ItemHeadResponse(const zim::Item& item, const std::string& mimetype) :
+  Response(),
+  m_item(item),
+  m_mimeType(mimetype)
+{
+  set_kind(Response::ZIM_CONTENT);
+  add_header(MHD_HTTP_HEADER_CONTENT_TYPE, m_mimeType);
+}
+
+MHD_Response*
+ItemHeadResponse::create_mhd_response(const RequestContext& request)
+{
+  // Mirror ContentResponse::create_mhd_response() for the content of the item
+  size_t contentLength = m_item.getSize();
+  bool isCompressed = false;
+  if ( request.can_compress()
+    && contentLength > KIWIX_MIN_CONTENT_SIZE_TO_COMPRESS ) {
+    const auto key = getCompressedSizeKey(m_etag, getZimItemKey(m_item));
+    if ( m_etag && getCompressedSizeCache().get(key, contentLength) ) {
+      isCompressed = true;
+    } else {
+      std::string content = m_item.getData();
+      isCompressed = compress(content);
+      contentLength = content.size();
+      if ( isCompressed && m_etag ) {
+        getCompressedSizeCache().put(key, contentLength);
+      }
+    }
+  }
+
+  MHD_Response* response = MHD_create_response_from_callback(contentLength,
+                                               16384,
+                                               callback_reader_no_body,
+                                               nullptr,
+                                               nullptr);
+
+  if (isCompressed) {
+    m_etag.set_option(ETag::COMPRESSED_CONTENT);
+    MHD_add_response_header(
+        response, MHD_HTTP_HEADER_VARY, "Accept-Encoding");
+    MHD_add_response_header(
+        response, MHD_HTTP_HEADER_CONTENT_ENCODING, "gzip");
+  }
+  return response;
+}
+
+StreamingResponse::StreamingResponse(ContentGenerator generator, const std::string& mimetype) :
+  Response(),
+  m_generator(std::move(generator)),
+  m_mimeType(mimetype)
+{
+  add_header(MHD_HTTP_HEADER_CONTENT_TYPE, m_mimeType);
+}
+
+MHD_Response*
+StreamingResponse::create_mhd_response(const RequestContext& request)
+{
+  const bool isCompressed = request.can_compress()
+                         && is_compressible_mime_type(m_mimeType);
+
+  MHD_Response* response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN,
+                                               16384,
+                                               callback_reader_from_generator,
+                                               new RunningStreamingResponse(std::move(m_generator), request.get_cancellation_token(), isCompressed),
+                                               callback_free_streaming_response);
+
+  if (isCompressed) {
+    m_etag.set_option(ETag::COMPRESSED_CONTENT);
+    MHD_add_response_header(
+        response, MHD_HTTP_HEADER_VARY, "Accept-Encoding");
+    MHD_add_response_header(
+        response, MHD_HTTP_HEADER_CONTENT_ENCODING, "gzip");
+  }
+  return response;
+}
 
 }
@@ -21,6 +21,7 @@
 #ifndef KIWIXLIB_SERVER_RESPONSE_H
 #define KIWIXLIB_SERVER_RESPONSE_H
 
+#include <functional>
 #include <string>
 #include <map>
 
@@ -113,6 +114,13 @@ class ContentResponse : public Response {
   private:
     std::string m_content;
     std::string m_mimeType;
+
+    // Identifies the ZIM item (within the archive designated by the ETag)
+    // that the content was read from. Empty if the content doesn't come
+    // from a ZIM item.
+    std::string m_zimItemKey;
+
+    friend class ItemResponse;
  };
 
 class ContentResponseBlueprint
@@ -140,7 +148,7 @@ protected: //data
   const RequestContext& m_request;
   const int m_httpStatusCode;
   const std::string m_mimeType;
-  const std::string m_template;
+  const std::string& m_template; // one of RESOURCE::templates::*
   const bool m_includeKiwixResponseData;
   std::unique_ptr<Data> m_data;
 };
@@ -200,6 +208,44 @@ class ItemResponse : public Response {
     std::string m_mimeType;
 };
 
+// Response to a HEAD request for the full content of a compressible ZIM item.
+// It carries the same headers as the ContentResponse that would be sent for
+// a GET request, but they are computed from the item metadata and, if the
+// content must be compressed, from the size of a previously compressed copy
+// of the item. The item data is read and compressed only if that size is not
+// known yet.
+class ItemHeadResponse : public Response {
+  public:
+    ItemHeadResponse(const zim::Item& item, const std::string& mimetype);
+
+  private:
+    MHD_Response* create_mhd_response(const RequestContext& request);
+
+    zim::Item m_item;
+    std::string m_mimeType;
+};
+
+// Response whose content is produced piece by piece while it is being sent
+// (using chunked transfer encoding), so that a large content doesn't have to
+// be fully built in memory before the first byte of it is sent. If the client
+// accepts it, the content is gzip-compressed on the fly.
+class StreamingResponse : public Response {
+  public: // types
+    // Stores the next piece of the content in its argument and returns
+    // false if that was the last piece. Called from the thread sending the
+    // response; stops being called if the request is cancelled.
+    typedef std::function<bool(std::string&)> ContentGenerator;
+
+  public: // functions
+    StreamingResponse(ContentGenerator generator, const std::string& mimetype);
+
+  private:
+    MHD_Response* create_mhd_response(const RequestContext& request);
+
+    ContentGenerator m_generator;
+    std::string m_mimeType;
+};
+
 struct BlockExternalLinkResponse : ContentResponseBlueprint
 {
   BlockExternalLinkResponse(const RequestContext& request,
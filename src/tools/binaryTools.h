@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_BINARYTOOLS_H
+#define KIWIX_BINARYTOOLS_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace kiwix
+{
+
+/**
+ * Appends values to a buffer in a compact binary form.
+ *
+ * The integers are written in the byte order of the host, so the data is
+ * meant to be read back on the same machine only (e.g. by a cache).
+ */
+class BinaryWriter
+{
+  public: // functions
+    explicit BinaryWriter(std::string& out) : m_out(out) {}
+
+    void writeInt(uint64_t value)
+    {
+      m_out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeBool(bool value) { m_out.push_back(value ? 1 : 0); }
+
+    void writeString(const std::string& value)
+    {
+      writeInt(value.size());
+      m_out.append(value);
+    }
+
+  private: // data
+    std::string& m_out;
+};
+
+/**
+ * Reads the values written by a BinaryWriter.
+ *
+ * Reading past the end of the data throws std::runtime_error.
+ */
+class BinaryReader
+{
+  public: // functions
+    BinaryReader(const char* data, size_t size)
+      : m_pos(data),
+        m_end(data + size)
+    {}
+
+    explicit BinaryReader(const std::string& data)
+      : BinaryReader(data.data(), data.size())
+    {}
+
+    bool atEnd() const { return m_pos == m_end; }
+
+    uint64_t readInt()
+    {
+      uint64_t value;
+      std::memcpy(&value, consume(sizeof(value)), sizeof(value));
+      return value;
+    }
+
+    bool readBool() { return *consume(1) != 0; }
+
+    std::string readString()
+    {
+      const uint64_t size = readInt();
+      return std::string(consume(size), size);
+    }
+
+  private: // functions
+    const char* consume(uint64_t size)
+    {
+      if ( size > uint64_t(m_end - m_pos) ) {
+        throw std::runtime_error("Truncated binary data");
+      }
+      const char* const start = m_pos;
+      m_pos += size;
+      return start;
+    }
+
+  private: // data
+    const char* m_pos;
+    const char* const m_end;
+};
+
+} // namespace kiwix
+
+#endif // KIWIX_BINARYTOOLS_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_CANCELLATION_TOKEN_H
+#define KIWIX_CANCELLATION_TOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+namespace kiwix
+{
+
+// Thrown by CancellationToken::throwIfCancelled()
+class OperationCancelled : public std::exception
+{
+  public:
+    const char* what() const noexcept override { return "Operation cancelled"; }
+};
+
+/**
+ * A flag telling a long running operation that its result is no longer
+ * needed and that it should stop as soon as possible.
+ *
+ * The flag is set either explicitly with cancel() or as a result of polling
+ * an optional probe function (e.g. checking that the client that requested
+ * the operation is still connected).
+ */
+class CancellationToken
+{
+  private: // types
+    typedef std::chrono::steady_clock Clock;
+
+  public: // types
+    typedef std::function<bool()> Probe;
+
+  public: // functions
+    CancellationToken() = default;
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    // Sets the function called by isCancelled() (at most once per interval)
+    // to find out whether the operation must be cancelled.
+    void setProbe(Probe probe, Clock::duration interval)
+    {
+      std::lock_guard<std::mutex> lock(m_probeMutex);
+      m_probe = probe;
+      m_probeInterval = interval.count();
+      m_nextProbeTime.store(0, std::memory_order_relaxed);
+      m_hasProbe.store(bool(m_probe), std::memory_order_relaxed);
+    }
+
+    // Removes the probe. Once this function returns, the probe is no longer
+    // called (e.g. it can no longer use the resources that it checks).
+    void clearProbe()
+    {
+      std::lock_guard<std::mutex> lock(m_probeMutex);
+      m_probe = nullptr;
+      m_hasProbe.store(false, std::memory_order_relaxed);
+    }
+
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+    bool isCancelled() const
+    {
+      if ( m_cancelled.load(std::memory_order_relaxed) ) {
+        return true;
+      }
+
+      if ( m_hasProbe.load(std::memory_order_relaxed) ) {
+        const auto now = Clock::now().time_since_epoch().count();
+        if ( now >= m_nextProbeTime.load(std::memory_order_relaxed) ) {
+          std::lock_guard<std::mutex> lock(m_probeMutex);
+          if ( m_probe && now >= m_nextProbeTime.load(std::memory_order_relaxed) ) {
+            m_nextProbeTime.store(now + m_probeInterval, std::memory_order_relaxed);
+            if ( m_probe() ) {
+              m_cancelled.store(true, std::memory_order_relaxed);
+              return true;
+            }
+          }
+        }
+      }
+      return m_cancelled.load(std::memory_order_relaxed);
+    }
+
+    void throwIfCancelled() const
+    {
+      if ( isCancelled() ) {
+        throw OperationCancelled();
+      }
+    }
+
+  private: // data
+    mutable std::atomic<bool> m_cancelled{false};
+    // The probe is called with the mutex locked, so that clearProbe()
+    // waits for the end of a running call
+    mutable std::mutex m_probeMutex;
+    Probe m_probe;
+    Clock::rep m_probeInterval = 0;
+    std::atomic<bool> m_hasProbe{false};
+    mutable std::atomic<Clock::rep> m_nextProbeTime{0};
+};
+
+} // namespace kiwix
+
+#endif // KIWIX_CANCELLATION_TOKEN_H
@@ -23,7 +23,10 @@
 #define ZIM_CONCURRENT_CACHE_H
 
 #include "lrucache.h"
+#include "tracepoints.h"
+#include "instrumented_lock.h"
 
+#include <chrono>
 #include <future>
 #include <mutex>
 
@@ -47,8 +50,10 @@ private: // types
   typedef lru_cache<Key, ValuePlaceholder> Impl;
 
 public: // types
-  explicit ConcurrentCache(size_t maxEntries)
-    : impl_(maxEntries)
+  explicit ConcurrentCache(size_t maxEntries,
+                           const std::string& lockName = "ConcurrentCache::lock_")
+    : impl_(maxEntries),
+      lockCounters_(getLockCounters(lockName))
   {}
 
   // Gets the entry corresponding to the given key. If the entry is not in the
@@ -64,35 +69,66 @@ public: // types
   Value getOrPut(const Key& key, F f)
   {
     std::promise<Value> valuePromise;
-    std::unique_lock<std::mutex> l(lock_);
+    Lock l(lock_, lockCounters_);
     const auto x = impl_.getOrPut(key, valuePromise.get_future().share());
     l.unlock();
     if ( x.miss() ) {
+      KIWIX_TRACE1(cache_miss, this);
       try {
         valuePromise.set_value(f());
       } catch (std::exception& e) {
         drop(key);
         throw;
       }
+    } else {
+      KIWIX_TRACE1(cache_hit, this);
     }
 
     return x.value().get();
   }
 
+  // Gets the entry corresponding to the given key without ever blocking.
+  // Returns false if the entry is not in the cache or if it is still being
+  // generated (by a concurrent call to getOrPut()).
+  bool getIfReady(const Key& key, Value& value)
+  {
+    Lock l(lock_, lockCounters_);
+    const auto x = impl_.get(key);
+    l.unlock();
+    if ( x.miss() ) {
+      return false;
+    }
+    const ValuePlaceholder& placeholder = x.value();
+    if ( placeholder.wait_for(std::chrono::seconds(0)) != std::future_status::ready ) {
+      return false;
+    }
+    try {
+      value = placeholder.get();
+      return true;
+    } catch (...) {
+      // the generation of the entry failed
+      return false;
+    }
+  }
+
   bool drop(const Key& key)
   {
-    std::unique_lock<std::mutex> l(lock_);
+    Lock l(lock_, lockCounters_);
     return impl_.drop(key);
   }
 
   size_t setMaxSize(size_t new_size) {
-    std::unique_lock<std::mutex> l(lock_);
+    Lock l(lock_, lockCounters_);
     return  impl_.setMaxSize(new_size);
   }
 
+protected: // types
+  typedef InstrumentedLock<std::mutex> Lock;
+
 protected: // data
   Impl impl_;
   std::mutex lock_;
+  LockCounters& lockCounters_;
 };
 
 
@@ -146,8 +182,10 @@ private: // types
   typedef lru_cache<Key, ValuePlaceholder> Impl;
 
 public: // types
-  explicit ConcurrentCache(size_t maxEntries)
-    : impl_(maxEntries)
+  explicit ConcurrentCache(size_t maxEntries,
+                           const std::string& lockName = "ConcurrentCache::lock_")
+    : impl_(maxEntries),
+      lockCounters_(getLockCounters(lockName))
   {}
 
   // Gets the entry corresponding to the given key. If the entry is not in the
@@ -163,10 +201,11 @@ public: // types
   Value getOrPut(const Key& key, F f)
   {
     std::promise<Value> valuePromise;
-    std::unique_lock<std::mutex> l(lock_);
+    Lock l(lock_, lockCounters_);
     const auto x = impl_.getOrPut(key, valuePromise.get_future().share());
     l.unlock();
     if ( x.miss() ) {
+      KIWIX_TRACE1(cache_miss, this);
       // Try to get back the shared_ptr from the weak_ptr first.
       try {
         valuePromise.set_value(m_weakStore.get(key));
@@ -180,6 +219,8 @@ public: // types
           throw;
         }
       }
+    } else {
+      KIWIX_TRACE1(cache_hit, this);
     }
 
     return x.value().get();
@@ -187,19 +228,23 @@ public: // types
 
   bool drop(const Key& key)
   {
-    std::unique_lock<std::mutex> l(lock_);
+    Lock l(lock_, lockCounters_);
     return impl_.drop(key);
   }
 
   size_t setMaxSize(size_t new_size) {
-    std::unique_lock<std::mutex> l(lock_);
+    Lock l(lock_, lockCounters_);
     return  impl_.setMaxSize(new_size);
   }
 
+protected: // types
+  typedef InstrumentedLock<std::mutex> Lock;
+
 protected: // data
   std::mutex lock_;
   Impl impl_;
   WeakStore<Key, RawValue> m_weakStore;
+  LockCounters& lockCounters_;
 };
 
 } // namespace kiwix
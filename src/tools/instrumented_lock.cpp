@@ -0,0 +1,183 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "tools/instrumented_lock.h"
+#include "tools/otherTools.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace kiwix
+{
+
+namespace
+{
+
+void updateMax(std::atomic<uint64_t>& maxValue, uint64_t value)
+{
+  uint64_t current = maxValue.load(std::memory_order_relaxed);
+  while ( value > current
+       && !maxValue.compare_exchange_weak(current, value, std::memory_order_relaxed) ) {
+  }
+}
+
+class LockRegistry
+{
+  public:
+    LockCounters& get(const std::string& name)
+    {
+      std::lock_guard<std::mutex> l(m_mutex);
+      auto& counters = m_counters[name];
+      if ( !counters ) {
+        counters.reset(new LockCounters(name));
+      }
+      return *counters;
+    }
+
+    std::vector<LockStatistics> getStatistics() const
+    {
+      std::lock_guard<std::mutex> l(m_mutex);
+      std::vector<LockStatistics> result;
+      for ( const auto& kv : m_counters ) {
+        result.push_back(kv.second->getStatistics());
+      }
+      return result;
+    }
+
+    void reset()
+    {
+      std::lock_guard<std::mutex> l(m_mutex);
+      for ( const auto& kv : m_counters ) {
+        kv.second->reset();
+      }
+    }
+
+  private: // data
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<LockCounters>> m_counters;
+};
+
+LockRegistry& getLockRegistry()
+{
+  // Never destroyed so that locks can be used during static destruction
+  static LockRegistry* registry = new LockRegistry;
+  return *registry;
+}
+
+// Mutexes currently owned and measured by this thread. A thread rarely holds
+// more than a couple of locks at the same time, so a vector is good enough.
+thread_local std::vector<const void*> ownedMutexes;
+
+} // unnamed namespace
+
+void LockCounters::recordAcquisition(uint64_t waitNs, bool contended)
+{
+  m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if ( contended ) {
+    m_contentions.fetch_add(1, std::memory_order_relaxed);
+    m_totalWaitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    updateMax(m_maxWaitNs, waitNs);
+  }
+}
+
+void LockCounters::recordRelease(uint64_t holdNs)
+{
+  m_totalHoldNs.fetch_add(holdNs, std::memory_order_relaxed);
+  updateMax(m_maxHoldNs, holdNs);
+}
+
+LockStatistics LockCounters::getStatistics() const
+{
+  LockStatistics stats;
+  stats.name = m_name;
+  stats.acquisitions = m_acquisitions.load(std::memory_order_relaxed);
+  stats.contentions = m_contentions.load(std::memory_order_relaxed);
+  stats.totalWaitNs = m_totalWaitNs.load(std::memory_order_relaxed);
+  stats.maxWaitNs = m_maxWaitNs.load(std::memory_order_relaxed);
+  stats.totalHoldNs = m_totalHoldNs.load(std::memory_order_relaxed);
+  stats.maxHoldNs = m_maxHoldNs.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void LockCounters::reset()
+{
+  m_acquisitions.store(0, std::memory_order_relaxed);
+  m_contentions.store(0, std::memory_order_relaxed);
+  m_totalWaitNs.store(0, std::memory_order_relaxed);
+  m_maxWaitNs.store(0, std::memory_order_relaxed);
+  m_totalHoldNs.store(0, std::memory_order_relaxed);
+  m_maxHoldNs.store(0, std::memory_order_relaxed);
+}
+
+LockCounters& getLockCounters(const std::string& name)
+{
+  return getLockRegistry().get(name);
+}
+
+namespace lock_instrumentation
+{
+
+std::atomic<bool> enabled{getEnvVar<int>("KIWIX_LOCK_STATS", 0) != 0};
+
+void setEnabled(bool value)
+{
+  enabled.store(value, std::memory_order_relaxed);
+}
+
+bool markOwned(const void* mutex)
+{
+  if ( std::find(ownedMutexes.begin(), ownedMutexes.end(), mutex) != ownedMutexes.end() ) {
+    return false;
+  }
+  ownedMutexes.push_back(mutex);
+  return true;
+}
+
+void unmarkOwned(const void* mutex)
+{
+  const auto it = std::find(ownedMutexes.begin(), ownedMutexes.end(), mutex);
+  if ( it != ownedMutexes.end() ) {
+    ownedMutexes.erase(it);
+  }
+}
+
+} // namespace lock_instrumentation
+
+bool isLockInstrumentationEnabled()
+{
+  return lock_instrumentation::isEnabled();
+}
+
+std::vector<LockStatistics> getLockStatistics()
+{
+  if ( !isLockInstrumentationEnabled() ) {
+    return {};
+  }
+  return getLockRegistry().getStatistics();
+}
+
+void resetLockStatistics()
+{
+  getLockRegistry().reset();
+}
+
+} // namespace kiwix
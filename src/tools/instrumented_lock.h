@@ -0,0 +1,174 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_INSTRUMENTED_LOCK_H
+#define KIWIX_INSTRUMENTED_LOCK_H
+
+#include "lock_stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace kiwix
+{
+
+/**
+ * Counters accumulated for all instances of a named lock.
+ *
+ * Objects of this class are created by getLockCounters() and live until the
+ * end of the process, so references to them can be kept freely.
+ */
+class LockCounters
+{
+  public:
+    explicit LockCounters(const std::string& name) : m_name(name) {}
+    LockCounters(const LockCounters&) = delete;
+    LockCounters& operator=(const LockCounters&) = delete;
+
+    void recordAcquisition(uint64_t waitNs, bool contended);
+    void recordRelease(uint64_t holdNs);
+
+    LockStatistics getStatistics() const;
+    void reset();
+
+  private: // data
+    const std::string m_name;
+    std::atomic<uint64_t> m_acquisitions{0};
+    std::atomic<uint64_t> m_contentions{0};
+    std::atomic<uint64_t> m_totalWaitNs{0};
+    std::atomic<uint64_t> m_maxWaitNs{0};
+    std::atomic<uint64_t> m_totalHoldNs{0};
+    std::atomic<uint64_t> m_maxHoldNs{0};
+};
+
+// Returns the counters of the lock with the given name, creating them on
+// first use. The lookup is not cheap: callers should keep the reference.
+LockCounters& getLockCounters(const std::string& name);
+
+namespace lock_instrumentation
+{
+
+// Checked by every acquisition of an instrumented lock, so it is read
+// inline rather than through isLockInstrumentationEnabled()
+extern std::atomic<bool> enabled;
+
+inline bool isEnabled()
+{
+  return enabled.load(std::memory_order_relaxed);
+}
+
+// Overrides the KIWIX_LOCK_STATS environment variable (used by the tests)
+void setEnabled(bool value);
+
+// Registers the mutex as owned by the current thread. Returns false if
+// it is already owned (nested acquisition of a recursive mutex).
+bool markOwned(const void* mutex);
+void unmarkOwned(const void* mutex);
+
+} // namespace lock_instrumentation
+
+/**
+ * A lock guard recording wait and hold times of the lock in LockCounters.
+ *
+ * It can be used with any Lockable type (std::mutex, std::recursive_mutex,
+ * a deferred std::unique_lock, ...). Like std::unique_lock, it can be
+ * unlocked before its destruction.
+ *
+ * When lock instrumentation is disabled (see isLockInstrumentationEnabled())
+ * it behaves as a plain lock guard. The instrumentation can be enabled or
+ * disabled while the lock is held.
+ */
+template<class Mutex>
+class InstrumentedLock
+{
+  private: // types
+    typedef std::chrono::steady_clock Clock;
+
+  public: // functions
+    InstrumentedLock(Mutex& mutex, LockCounters& counters)
+      : m_mutex(mutex),
+        m_counters(counters)
+    {
+      lock();
+    }
+
+    ~InstrumentedLock()
+    {
+      if ( m_ownsLock ) {
+        unlock();
+      }
+    }
+
+    InstrumentedLock(const InstrumentedLock&) = delete;
+    InstrumentedLock& operator=(const InstrumentedLock&) = delete;
+
+    void lock()
+    {
+      if ( !lock_instrumentation::isEnabled() ) {
+        m_mutex.lock();
+        m_ownsLock = true;
+        return;
+      }
+
+      const auto start = Clock::now();
+      const bool contended = !m_mutex.try_lock();
+      if ( contended ) {
+        m_mutex.lock();
+      }
+      m_ownsLock = true;
+      m_acquisitionTime = Clock::now();
+      m_measured = lock_instrumentation::markOwned(&m_mutex);
+      if ( m_measured ) {
+        m_counters.recordAcquisition(nanoseconds(m_acquisitionTime - start),
+                                     contended);
+      }
+    }
+
+    void unlock()
+    {
+      if ( m_measured ) {
+        lock_instrumentation::unmarkOwned(&m_mutex);
+        m_counters.recordRelease(nanoseconds(Clock::now() - m_acquisitionTime));
+        m_measured = false;
+      }
+      m_ownsLock = false;
+      m_mutex.unlock();
+    }
+
+    bool owns_lock() const { return m_ownsLock; }
+
+  private: // functions
+    static uint64_t nanoseconds(Clock::duration d)
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+  private: // data
+    Mutex& m_mutex;
+    LockCounters& m_counters;
+    bool m_ownsLock = false;
+    bool m_measured = false;
+    Clock::time_point m_acquisitionTime;
+};
+
+} // namespace kiwix
+
+#endif // KIWIX_INSTRUMENTED_LOCK_H
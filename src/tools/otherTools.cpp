@@ -36,6 +36,7 @@
 #include "libkiwix-resources.h"
 
 #include <map>
+#include <memory>
 #include <sstream>
 #include <pugixml.hpp>
 
@@ -319,11 +320,81 @@ kainjow::mustache::data kiwix::onlyAsNonEmptyMustacheValue(const std::string& s)
        : kainjow::mustache::data(s);
 }
 
+namespace
+{
+
+// Pre-parsed versions of the mustache templates compiled into libkiwix.
+// They are looked up by the address of the template string, which is
+// stable since the RESOURCE::templates::* strings live until the end of
+// the process. Once built the registry is never modified, so it can be
+// shared by all threads without locking. However, rendering a template
+// isn't a const operation (kainjow::mustache::mustache::render() is
+// non-const and keeps some state in the template object), so the registered
+// templates must not be rendered directly but copied first.
+class TemplateRegistry
+{
+  public:
+    TemplateRegistry()
+    {
+      add(RESOURCE::templates::search_result_html);
+      add(RESOURCE::templates::search_result_xml);
+      add(RESOURCE::templates::error_html);
+      add(RESOURCE::templates::error_xml);
+      add(RESOURCE::templates::index_html);
+      add(RESOURCE::templates::suggestion_json);
+      add(RESOURCE::templates::captured_external_html);
+      add(RESOURCE::templates::catalog_v2_root_xml);
+      add(RESOURCE::templates::catalog_v2_categories_xml);
+      add(RESOURCE::templates::catalog_v2_languages_xml);
+      add(RESOURCE::templates::url_of_search_results_css_tmpl);
+      add(RESOURCE::templates::viewer_settings_js);
+      add(RESOURCE::templates::no_js_library_page_html);
+      add(RESOURCE::templates::no_js_download_html);
+      add(RESOURCE::templates::sexy404_html);
+      add(RESOURCE::templates::sexy500_html);
+    }
+
+    const kainjow::mustache::mustache* get(const std::string& template_str) const
+    {
+      const auto it = m_templates.find(&template_str);
+      return it != m_templates.end() ? it->second.get() : nullptr;
+    }
+
+  private:
+    void add(const std::string& template_str)
+    {
+      m_templates[&template_str].reset(new kainjow::mustache::mustache(template_str));
+    }
+
+  private: // data
+    std::map<const std::string*, std::unique_ptr<kainjow::mustache::mustache>> m_templates;
+};
+
+const TemplateRegistry& getTemplateRegistry()
+{
+  static const TemplateRegistry registry;
+  return registry;
+}
+
+} // unnamed namespace
+
+void kiwix::precompileTemplates()
+{
+  getTemplateRegistry();
+}
+
 std::string kiwix::render_template(const std::string& template_str, kainjow::mustache::data data)
 {
-  kainjow::mustache::mustache tmpl(template_str);
   std::stringstream ss;
-  tmpl.render(data, [&ss](const std::string& str) { ss << str; });
+  const auto renderer = [&ss](const std::string& str) { ss << str; };
+  if ( const auto parsedTmpl = getTemplateRegistry().get(template_str) ) {
+    // Copying the parsed template is much cheaper than parsing it again
+    kainjow::mustache::mustache tmpl(*parsedTmpl);
+    tmpl.render(data, renderer);
+  } else {
+    kainjow::mustache::mustache tmpl(template_str);
+    tmpl.render(data, renderer);
+  }
   return ss.str();
 }
 
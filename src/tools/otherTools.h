@@ -56,8 +56,14 @@ namespace kiwix
   // otherwise kainjow::mustache::data(value)
   kainjow::mustache::data onlyAsNonEmptyMustacheValue(const std::string& s);
 
+  // Templates compiled into libkiwix (RESOURCE::templates::*) are parsed
+  // only once, any other template string is parsed on every call.
   std::string render_template(const std::string& template_str, kainjow::mustache::data data);
 
+  // Parses all templates compiled into libkiwix (otherwise done on the first
+  // call to render_template()).
+  void precompileTemplates();
+
   template<typename T>
   T getEnvVar(const char* name, const T& defaultValue)
   {
@@ -44,6 +44,7 @@
 #include <iomanip>
 #include <iostream>
 #include <algorithm>
+#include <filesystem>
 
 #ifdef _WIN32
 # define SEPARATOR "\\"
@@ -414,6 +415,47 @@ bool writeTextFile(const std::string& path, const std::string& content)
   return true;
 }
 
+bool writeFileAtomically(const std::string& path, const std::string& content)
+{
+  const auto fsPath = std::filesystem::u8path(path);
+  auto tmpPath = fsPath;
+  tmpPath += ".tmp";
+  std::ofstream out(tmpPath, std::ios::binary);
+  out.write(content.data(), content.size());
+  out.close();
+  std::error_code ec;
+  if (out) {
+    std::filesystem::rename(tmpPath, fsPath, ec);
+    if (!ec)
+      return true;
+  }
+  std::filesystem::remove(tmpPath, ec);
+  return false;
+}
+
+bool getFileStamp(const std::string& path, FileStamp* stamp)
+{
+#ifdef _WIN32
+  struct _stat64 filestatus;
+  if (_wstat64(Utf8ToWide(path).c_str(), &filestatus) != 0)
+    return false;
+  stamp->mtime = filestatus.st_mtime;
+#else
+  struct stat filestatus;
+  if (stat(path.c_str(), &filestatus) != 0)
+    return false;
+# ifdef __APPLE__
+  const auto& mtime = filestatus.st_mtimespec;
+# else
+  const auto& mtime = filestatus.st_mtim;
+# endif
+  stamp->mtime = int64_t(mtime.tv_sec) * 1000000000 + mtime.tv_nsec;
+#endif
+  stamp->size = filestatus.st_size;
+  stamp->inode = filestatus.st_ino;
+  return true;
+}
+
 std::string kiwix::getCurrentDirectory()
 {
 #ifdef _WIN32
@@ -20,6 +20,7 @@
 #ifndef KIWIX_PATHTOOLS_H
 #define KIWIX_PATHTOOLS_H
 
+#include <cstdint>
 #include <string>
 
 #ifdef _WIN32
@@ -33,5 +34,25 @@ std::string makeTmpDirectory();
 bool copyFile(const std::string& sourcePath, const std::string& destPath);
 bool writeTextFile(const std::string& path, const std::string& content);
 
+/* Write a (binary) file so that it is never seen half-written: the content
+ * is written to a temporary file which then replaces the file. */
+bool writeFileAtomically(const std::string& path, const std::string& content);
+
+/* The identity of a version of a file: if the file is modified or replaced,
+ * its stamp changes (within the precision of the file system). */
+struct FileStamp
+{
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  uint64_t inode = 0;
+
+  bool operator==(const FileStamp& other) const {
+    return size == other.size && mtime == other.mtime && inode == other.inode;
+  }
+  bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+bool getFileStamp(const std::string& path, FileStamp* stamp);
+
 #endif
 
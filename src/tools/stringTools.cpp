@@ -22,6 +22,7 @@
 #include "tools/stringTools.h"
 
 #include "tools/pathTools.h"
+#include <unicode/coll.h>
 #include <unicode/normlzr.h>
 #include <unicode/rep.h>
 #include <unicode/translit.h>
@@ -108,6 +109,37 @@ std::string kiwix::removeAccents(const std::string& text)
   return unaccentedText;
 }
 
+std::string kiwix::getCollationKey(const std::string& text)
+{
+  // The const member functions of an ICU collator can be called
+  // concurrently from multiple threads
+  static const std::unique_ptr<const icu::Collator> collator = []() {
+    UErrorCode status = U_ZERO_ERROR;
+    std::unique_ptr<icu::Collator> c(icu::Collator::createInstance(icu::Locale::getRoot(), status));
+    if ( U_FAILURE(status) ) {
+      c.reset();
+    }
+    return c;
+  }();
+
+  if ( !collator ) {
+    return text;
+  }
+
+  const auto ustring = icu::UnicodeString::fromUTF8(text);
+  std::string key(ustring.length() * 2 + 16, '\0');
+  auto keyBuffer = reinterpret_cast<uint8_t*>(&key[0]);
+  int32_t keySize = collator->getSortKey(ustring, keyBuffer, key.size());
+  if ( keySize > int32_t(key.size()) ) {
+    key.resize(keySize);
+    keyBuffer = reinterpret_cast<uint8_t*>(&key[0]);
+    keySize = collator->getSortKey(ustring, keyBuffer, key.size());
+  }
+  // Drop the terminating zero byte
+  key.resize(keySize > 0 ? keySize - 1 : 0);
+  return key;
+}
+
 /* Prepare integer for display */
 std::string kiwix::beautifyInteger(uint64_t number)
 {
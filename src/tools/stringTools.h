@@ -39,6 +39,11 @@ void stringReplacement(std::string& str,
 std::string encodeDiples(const std::string& str);
 
 std::string removeAccents(const std::string& text);
+
+/* Returns a key such that comparing the keys of two strings byte per byte
+ * orders the strings like a human would do (ignoring the case and
+ * accents unless they are the only difference, etc). */
+std::string getCollationKey(const std::string& text);
 void loadICUExternalTables();
 
 class ICULanguageInfo
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_TRACEPOINTS_H
+#define KIWIX_TRACEPOINTS_H
+
+/**
+ * Static (USDT) tracepoints for ad-hoc profiling with bpftrace, perf or
+ * SystemTap.
+ *
+ * The probes are compiled in only when libkiwix is configured with
+ * `-Dusdt=true`. Otherwise the KIWIX_TRACE* macros expand to nothing and
+ * their arguments are not evaluated. An enabled but unattached probe costs
+ * a single nop instruction.
+ *
+ * All probes belong to the `libkiwix` provider, for example:
+ *
+ *   bpftrace -e 'usdt:/usr/lib/libkiwix.so:libkiwix:request_start
+ *                { printf("%s\n", str(arg0)); }'
+ *
+ * Available probes:
+ *   request_start(const char* url, const char* method)
+ *   request_end(const char* url, int httpStatusCode)
+ *   cache_hit(void* cache)
+ *   cache_miss(void* cache)
+ *   archive_open_start(const char* bookId)
+ *   archive_open_end(const char* bookId)
+ *   search_start(const char* pattern, size_t bookCount)
+ *   search_end(const char* pattern, int estimatedMatches)
+ *   item_read(uint64_t offset, size_t size)
+ */
+
+#ifdef KIWIX_USDT_PROBES
+
+#include <sys/sdt.h>
+
+#define KIWIX_TRACE0(name)       DTRACE_PROBE(libkiwix, name)
+#define KIWIX_TRACE1(name, a)    DTRACE_PROBE1(libkiwix, name, a)
+#define KIWIX_TRACE2(name, a, b) DTRACE_PROBE2(libkiwix, name, a, b)
+
+#else // KIWIX_USDT_PROBES
+
+#define KIWIX_TRACE0(name)       do {} while(0)
+#define KIWIX_TRACE1(name, a)    do {} while(0)
+#define KIWIX_TRACE2(name, a, b) do {} while(0)
+
+#endif // KIWIX_USDT_PROBES
+
+#endif // KIWIX_TRACEPOINTS_H
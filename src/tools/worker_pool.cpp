@@ -0,0 +1,72 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "worker_pool.h"
+
+namespace kiwix
+{
+
+WorkerPool::WorkerPool(size_t threadCount)
+{
+  m_threads.reserve(threadCount);
+  for ( size_t i = 0; i < threadCount; ++i ) {
+    m_threads.emplace_back(&WorkerPool::run, this);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_taskAdded.notify_all();
+  for ( auto& thread : m_threads ) {
+    thread.join();
+  }
+}
+
+void WorkerPool::push(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(task));
+  }
+  m_taskAdded.notify_one();
+}
+
+void WorkerPool::run()
+{
+  while ( true ) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_taskAdded.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+      if ( m_tasks.empty() ) {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    // Exceptions thrown by the task are stored in its future
+    task();
+  }
+}
+
+} // namespace kiwix
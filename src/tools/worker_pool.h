@@ -0,0 +1,134 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_WORKER_POOL_H
+#define KIWIX_WORKER_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace kiwix
+{
+
+/**
+ * A fixed set of threads executing the tasks submitted to it in the order
+ * of submission.
+ *
+ * A task must not wait for the result of another task of the same pool.
+ */
+class WorkerPool
+{
+  public: // functions
+    explicit WorkerPool(size_t threadCount);
+
+    // Executes the tasks already submitted and stops the threads
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t getThreadCount() const { return m_threads.size(); }
+
+    template<class F>
+    std::future<std::invoke_result_t<F>> submit(F f)
+    {
+      typedef std::packaged_task<std::invoke_result_t<F>()> Task;
+      const auto task = std::make_shared<Task>(std::move(f));
+      auto result = task->get_future();
+      push([task]() { (*task)(); });
+      return result;
+    }
+
+  private: // functions
+    void push(std::function<void()> task);
+    void run();
+
+  private: // data
+    std::mutex m_mutex;
+    std::condition_variable m_taskAdded;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+    std::vector<std::thread> m_threads;
+};
+
+/**
+ * Splits the range [0, count) into consecutive slices of at least
+ * minSliceSize items, calls f(first, last) for each slice [first, last) and
+ * returns the results in the order of the slices.
+ *
+ * The first slice is processed by the calling thread and the other ones by
+ * the threads of the pool (the range isn't split if the pool is null). All
+ * the slices are processed even if one of them throws; the first exception
+ * is then rethrown.
+ */
+template<class F>
+std::vector<std::invoke_result_t<F, size_t, size_t>>
+processInSlices(WorkerPool* pool, size_t count, size_t minSliceSize, F f)
+{
+  typedef std::invoke_result_t<F, size_t, size_t> Result;
+
+  const size_t maxSliceCount = pool ? pool->getThreadCount() + 1 : 1;
+  const size_t sliceCount = std::max<size_t>(1, std::min(maxSliceCount, count / std::max<size_t>(minSliceSize, 1)));
+  const size_t sliceSize = (count + sliceCount - 1) / sliceCount;
+
+  std::vector<std::future<Result>> otherSlices;
+  for ( size_t first = sliceSize; first < count; first += sliceSize ) {
+    const size_t last = std::min(first + sliceSize, count);
+    otherSlices.push_back(pool->submit([&f, first, last]() { return f(first, last); }));
+  }
+
+  std::vector<Result> results;
+  results.reserve(sliceCount);
+  std::exception_ptr error;
+  try {
+    results.push_back(f(0, std::min(sliceSize, count)));
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  // The slices refer to the data of the caller, so they must all be done
+  // before returning (or throwing)
+  for ( auto& slice : otherSlices ) {
+    try {
+      results.push_back(slice.get());
+    } catch (...) {
+      if ( !error ) {
+        error = std::current_exception();
+      }
+    }
+  }
+
+  if ( error ) {
+    std::rethrow_exception(error);
+  }
+  return results;
+}
+
+} // namespace kiwix
+
+#endif // KIWIX_WORKER_POOL_H
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "zim_metadata_cache.h"
+
+#include "book.h"
+#include "tools.h"
+#include "tools/binaryTools.h"
+
+#include <stdexcept>
+
+namespace kiwix
+{
+
+namespace
+{
+
+const char ZIM_METADATA_CACHE_MAGIC[] = "kiwix-zim-metadata-cache";
+
+// Must be incremented whenever the format of the cache files (including
+// the binary form of the books) changes
+const uint64_t ZIM_METADATA_CACHE_VERSION = 1;
+
+void writeFileStamp(BinaryWriter& writer, const FileStamp& stamp)
+{
+  writer.writeInt(stamp.size);
+  writer.writeInt(static_cast<uint64_t>(stamp.mtime));
+  writer.writeInt(stamp.inode);
+}
+
+FileStamp readFileStamp(BinaryReader& reader)
+{
+  FileStamp stamp;
+  stamp.size = reader.readInt();
+  stamp.mtime = static_cast<int64_t>(reader.readInt());
+  stamp.inode = reader.readInt();
+  return stamp;
+}
+
+} // unnamed namespace
+
+ZimMetadataCache::ZimMetadataCache(const std::string& path)
+  : m_path(path)
+{
+  load();
+}
+
+ZimMetadataCache::~ZimMetadataCache()
+{
+  save();
+}
+
+void ZimMetadataCache::load()
+{
+  const std::string content = getFileContent(m_path);
+  try {
+    BinaryReader reader(content);
+    if ( reader.readString() != ZIM_METADATA_CACHE_MAGIC
+      || reader.readInt() != ZIM_METADATA_CACHE_VERSION ) {
+      return;
+    }
+    std::map<std::string, Entry> entries;
+    for ( auto n = reader.readInt(); n != 0; --n ) {
+      const std::string zimPath = reader.readString();
+      Entry& entry = entries[zimPath];
+      entry.stamp = readFileStamp(reader);
+      entry.book = reader.readString();
+    }
+    if ( reader.atEnd() ) {
+      m_entries = std::move(entries);
+    }
+  } catch (const std::runtime_error&) {
+    // The cache file is missing or invalid, start with an empty cache
+  }
+}
+
+bool ZimMetadataCache::get(const std::string& zimPath, const FileStamp& stamp, Book* book)
+{
+  std::string bookData;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_entries.find(zimPath);
+    if ( it == m_entries.end() ) {
+      return false;
+    }
+    if ( it->second.stamp != stamp ) {
+      m_entries.erase(it);
+      m_modified = true;
+      return false;
+    }
+    bookData = it->second.book;
+  }
+
+  Book cachedBook;
+  try {
+    BinaryReader reader(bookData);
+    cachedBook.updateFromBinary(reader);
+  } catch (const std::runtime_error&) {
+    return false;
+  }
+  cachedBook.setReadOnly(book->readOnly());
+  cachedBook.setUrl(book->getUrl());
+  cachedBook.setOrigId(book->getOrigId());
+  cachedBook.setDownloadId(book->getDownloadId());
+  *book = cachedBook;
+  return true;
+}
+
+void ZimMetadataCache::put(const std::string& zimPath, const FileStamp& stamp, const Book& book)
+{
+  Entry entry;
+  entry.stamp = stamp;
+  BinaryWriter writer(entry.book);
+  book.writeBinary(writer);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries[zimPath] = std::move(entry);
+  m_modified = true;
+}
+
+bool ZimMetadataCache::save()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if ( !m_modified ) {
+    return true;
+  }
+
+  for ( auto it = m_entries.begin(); it != m_entries.end(); ) {
+    it = fileExists(it->first) ? std::next(it) : m_entries.erase(it);
+  }
+
+  std::string content;
+  BinaryWriter writer(content);
+  writer.writeString(ZIM_METADATA_CACHE_MAGIC);
+  writer.writeInt(ZIM_METADATA_CACHE_VERSION);
+  writer.writeInt(m_entries.size());
+  for ( const auto& kv : m_entries ) {
+    writer.writeString(kv.first);
+    writeFileStamp(writer, kv.second.stamp);
+    writer.writeString(kv.second.book);
+  }
+
+  m_modified = !writeFileAtomically(m_path, content);
+  return !m_modified;
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026 Kiwix <contact@kiwix.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#ifndef KIWIX_ZIM_METADATA_CACHE_H
+#define KIWIX_ZIM_METADATA_CACHE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "tools/pathTools.h"
+
+namespace kiwix
+{
+
+class Book;
+
+/**
+ * A persistent cache of the books read from ZIM files.
+ *
+ * The books are identified by the path of their ZIM file and are valid
+ * only as long as the stamp (size, modification time and inode) of the
+ * file doesn't change. The cache can be used by several threads.
+ */
+class ZimMetadataCache
+{
+ public:
+  /**
+   * Load the cache saved in a file (the cache starts empty if the file
+   * doesn't exist or is invalid).
+   *
+   * @param path the path of the cache file.
+   */
+  explicit ZimMetadataCache(const std::string& path);
+
+  /**
+   * Save the cache (see save()).
+   */
+  ~ZimMetadataCache();
+
+  ZimMetadataCache(const ZimMetadataCache&) = delete;
+  ZimMetadataCache& operator=(const ZimMetadataCache&) = delete;
+
+  /**
+   * Get the book of a ZIM file.
+   *
+   * The attributes of the book that aren't read from ZIM files (see
+   * Book::update(const zim::Archive&)) are kept.
+   *
+   * @param zimPath the path of the ZIM file.
+   * @param stamp the current stamp of the ZIM file.
+   * @param book the book to update.
+   * @return True if the book was found (and updated).
+   */
+  bool get(const std::string& zimPath, const FileStamp& stamp, Book* book);
+
+  /**
+   * Add the book of a ZIM file to the cache.
+   *
+   * @param zimPath the path of the ZIM file.
+   * @param stamp the stamp of the ZIM file before the book was read from it.
+   * @param book the book read from the ZIM file.
+   */
+  void put(const std::string& zimPath, const FileStamp& stamp, const Book& book);
+
+  /**
+   * Save the cache to its file if it was changed since it was loaded or
+   * saved. The books of the ZIM files that no longer exist are dropped.
+   *
+   * @return False if the cache had to be saved and could not be.
+   */
+  bool save();
+
+ private:
+  struct Entry
+  {
+    FileStamp stamp;
+    // The binary form of the book
+    std::string book;
+  };
+
+  void load();
+
+ private:
+  const std::string m_path;
+  std::mutex m_mutex;
+  std::map<std::string, Entry> m_entries;
+  bool m_modified = false;
+};
+
+}
+
+#endif // KIWIX_ZIM_METADATA_CACHE_H
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "../include/book.h"
+#include "../src/tools/binaryTools.h"
 #include <pugixml.hpp>
 
 namespace
@@ -222,3 +223,95 @@ TEST(BookTest, getLanguages)
     EXPECT_EQ(book.getLanguages(), Langs({ "eng", "ong", "ing" }));
   }
 }
+
+TEST(BookTest, booksWithTheSameAttributeValuesAreIndependent)
+{
+  kiwix::Book book1;
+  kiwix::Book book2;
+  book1.setTags("wikipedia;nopic;_category:wikipedia");
+  book2.setTags("wikipedia;nopic;_category:wikipedia");
+  book1.setLanguage("eng,fra");
+  book2.setLanguage("eng,fra");
+
+  book2.setTags("wikipedia;_category:other");
+  book2.setLanguage("deu");
+
+  EXPECT_EQ(book1.getTags(), "wikipedia;nopic;_category:wikipedia");
+  EXPECT_EQ(book1.getTagStr("category"), "wikipedia");
+  EXPECT_EQ(book1.getTagStr("pictures"), "no");
+  EXPECT_FALSE(book1.getTagBool("pictures"));
+  EXPECT_THROW(book1.getTagStr("nosuchtag"), std::out_of_range);
+  EXPECT_EQ(book1.getLanguages(), std::vector<std::string>({"eng", "fra"}));
+
+  EXPECT_EQ(book2.getTagStr("category"), "other");
+  EXPECT_EQ(book2.getTagStr("pictures"), "yes");
+  EXPECT_EQ(book2.getLanguages(), std::vector<std::string>({"deu"}));
+}
+
+TEST(BookTest, binaryFormRoundTrip)
+{
+  kiwix::Book book = makeBook(R"(
+      id="xyz"
+      downloadId="dl"
+      path="zara.zim"
+      url="book-url"
+      title="Zara"
+      description="A book"
+      language="eng,fra"
+      creator="Wikipedia"
+      publisher="Kiwix"
+      date="2020-01-01"
+      name="zara_en"
+      flavour="nopic"
+      origId="abc"
+      tags="youtube;_videos:yes;_category:videos"
+      articleCount="123"
+      mediaCount="45"
+      size="678"
+      favicon="Ym9vay1mYXZpY29u"
+      faviconMimeType="book-favicon-mimetype"
+      faviconUrl="favicon-url"
+  )", DATA_ABS_PATH);
+  book.setPathValid(true);
+
+  std::string data;
+  kiwix::BinaryWriter writer(data);
+  book.writeBinary(writer);
+  book.writeBinary(writer);
+
+  kiwix::BinaryReader reader(data);
+  kiwix::Book newBook;
+  newBook.updateFromBinary(reader);
+  EXPECT_FALSE(reader.atEnd());
+  newBook.updateFromBinary(reader);
+  EXPECT_TRUE(reader.atEnd());
+
+  EXPECT_EQ(newBook.getId(), "xyz");
+  EXPECT_EQ(newBook.getDownloadId(), "dl");
+  EXPECT_EQ(newBook.getPath(), ZARA_ABS_PATH);
+  EXPECT_TRUE(newBook.isPathValid());
+  EXPECT_EQ(newBook.getUrl(), "book-url");
+  EXPECT_EQ(newBook.getTitle(), "Zara");
+  EXPECT_EQ(newBook.getDescription(), "A book");
+  EXPECT_EQ(newBook.getLanguages(), std::vector<std::string>({"eng", "fra"}));
+  EXPECT_EQ(newBook.getCreator(), "Wikipedia");
+  EXPECT_EQ(newBook.getPublisher(), "Kiwix");
+  EXPECT_EQ(newBook.getDate(), "2020-01-01");
+  EXPECT_EQ(newBook.getName(), "zara_en");
+  EXPECT_EQ(newBook.getFlavour(), "nopic");
+  EXPECT_EQ(newBook.getOrigId(), "abc");
+  EXPECT_EQ(newBook.getTags(), "youtube;_videos:yes;_category:videos");
+  EXPECT_EQ(newBook.getCategory(), "videos");
+  EXPECT_EQ(newBook.getTagStr("videos"), "yes");
+  EXPECT_EQ(newBook.getArticleCount(), 123U);
+  EXPECT_EQ(newBook.getMediaCount(), 45U);
+  EXPECT_EQ(newBook.getSize(), 678U*1024);
+  const auto illustration = newBook.getIllustration(48);
+  EXPECT_EQ(illustration->getData(), "book-favicon");
+  EXPECT_EQ(illustration->mimeType, "book-favicon-mimetype");
+  EXPECT_EQ(illustration->url, "favicon-url");
+
+  // Truncated data is detected
+  kiwix::BinaryReader truncatedReader(data.data(), data.size() / 2 - 1);
+  EXPECT_THROW(newBook.updateFromBinary(truncatedReader), std::runtime_error);
+}
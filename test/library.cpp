@@ -18,6 +18,7 @@
  */
 
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <string>
 
 const char * sampleOpdsStream = R"(
@@ -317,6 +318,9 @@ const char sampleLibraryXML[] = R"(
 #include "../include/manager.h"
 #include "../include/book.h"
 #include "../include/bookmark.h"
+#include "../src/opds_dumper.h"
+#include "../src/tools/worker_pool.h"
+#include "../src/tools/instrumented_lock.h"
 
 namespace
 {
@@ -757,6 +761,52 @@ TEST_F(LibraryTest, sanityCheck)
   }));
 }
 
+TEST_F(LibraryTest, facetsFollowTheChangesOfTheLibrary)
+{
+  EXPECT_EQ(lib->getBookCount(true, false), 2U);
+  EXPECT_EQ(lib->getBookCount(false, true), 15U);
+  EXPECT_EQ(lib->getBookCount(false, false), 0U);
+  EXPECT_EQ(lib->getBooksLanguagesWithCounts(),
+            kiwix::Library::AttributeCounts({
+              {"deu", 1}, {"eng", 7}, {"fra", 8}, {"ita", 1}, {"spa", 1}
+            })
+  );
+
+  lib->removeBookById("example");
+  EXPECT_EQ(lib->getBookCount(true, true), 15U);
+  EXPECT_EQ(lib->getBookCount(true, false), 1U);
+  EXPECT_EQ(lib->getBooksLanguages(),
+            std::vector<std::string>({"eng", "fra", "ita", "spa"})
+  );
+  EXPECT_EQ(lib->getBooksCategories(), std::vector<std::string>({
+      "category_defined_via_category_element_only",
+      "category_defined_via_tags_only",
+      "category_element_overrides_tags",
+      "wikipedia"
+  }));
+  EXPECT_EQ(lib->getBooksPublishers(), std::vector<std::string>({
+      "",
+      "Kiwix",
+      "Wikipedia Publishing House"
+  }));
+
+  kiwix::Book book = lib->getBookByIdThreadSafe("raycharles");
+  book.setLanguage("fra");
+  book.setPublisher("Ray Charles Fans");
+  lib->addBook(book);
+  EXPECT_EQ(lib->getBookCount(true, true), 15U);
+  EXPECT_EQ(lib->getBooksLanguagesWithCounts(),
+            kiwix::Library::AttributeCounts({
+              {"eng", 6}, {"fra", 9}, {"ita", 1}
+            })
+  );
+  EXPECT_EQ(lib->getBooksPublishers(), std::vector<std::string>({
+      "",
+      "Ray Charles Fans",
+      "Wikipedia Publishing House"
+  }));
+}
+
 TEST_F(LibraryTest, categoryHandling)
 {
   EXPECT_EQ("", lib->getBookById("0c45160e-f917-760a-9159-dfe3c53cdcdd").getCategory());
@@ -1166,6 +1216,51 @@ TEST_F(LibraryTest, filterByMaxSize)
   );
 }
 
+TEST_F(LibraryTest, filterByMinSize)
+{
+  EXPECT_FILTER_RESULTS(kiwix::Filter().minSize(1000000000),
+    "Business talks about TED",
+    "TED\"talks\" - Business",
+    "Tania Louis"
+  );
+
+  EXPECT_FILTER_RESULTS(kiwix::Filter().minSize(100000).maxSize(200000),
+    "An example ZIM archive"
+  );
+}
+
+TEST_F(LibraryTest, filterByDate)
+{
+  EXPECT_FILTER_RESULTS(kiwix::Filter().dateFrom("2020"),
+    "An example ZIM archive",
+    "Ray Charles"
+  );
+
+  EXPECT_FILTER_RESULTS(kiwix::Filter().dateTo("2018-07"),
+    "TED\"talks\" - Business",
+    "Tania Louis"
+  );
+
+  EXPECT_FILTER_RESULTS(kiwix::Filter().dateFrom("2019-02-03").dateTo("2019-06-02"),
+    "Géographie par Wikipédia",
+    "Mathématiques",
+    "Movies & TV Stack Exchange",
+    "Mythology & Folklore Stack Exchange"
+  );
+
+  EXPECT_FILTER_RESULTS(kiwix::Filter().lang("eng").dateFrom("2019"),
+    "Islam Stack Exchange",
+    "Movies & TV Stack Exchange",
+    "Mythology & Folklore Stack Exchange",
+    "Ray Charles"
+  );
+
+  for ( const char* date : { "", "abc", "2023-1", "2023-13", "2023-01-32", "2023-01-01T00:00:00Z" } ) {
+    EXPECT_THROW(kiwix::Filter().dateFrom(date), std::invalid_argument) << date;
+    EXPECT_THROW(kiwix::Filter().dateTo(date), std::invalid_argument) << date;
+  }
+}
+
 TEST_F(LibraryTest, filterByMultipleCriteria)
 {
   EXPECT_FILTER_RESULTS(kiwix::Filter().query("Wiki").creator("Wikipedia"),
@@ -1194,18 +1289,160 @@ TEST_F(LibraryTest, filterByMultipleCriteria)
   );
 }
 
+TEST_F(LibraryTest, filterPage)
+{
+  const kiwix::Filter filters[] = {
+    kiwix::Filter(),
+    kiwix::Filter().local(false),
+    kiwix::Filter().lang("fra"),
+    kiwix::Filter().query("Wiki").creator("Wikipedia").maxSize(100000000UL),
+  };
+
+  for ( const auto& f : filters ) {
+    const auto allBookIds = lib->filter(f);
+    for ( size_t pageSize : { 1, 3, 100 } ) {
+      kiwix::Library::BookIdCollection pagedBookIds, cursoredBookIds;
+      std::string cursor;
+      for ( size_t start = 0; start < allBookIds.size(); start += pageSize ) {
+        const auto page = lib->filterPage(f, start, pageSize);
+        EXPECT_EQ(page.totalCount, allBookIds.size());
+        EXPECT_EQ(page.startIndex, start);
+        pagedBookIds.insert(pagedBookIds.end(), page.bookIds.begin(), page.bookIds.end());
+
+        const auto cursoredPage = start == 0
+                                ? lib->filterPage(f, 0, pageSize)
+                                : lib->filterPageAfter(f, cursor, pageSize);
+        EXPECT_EQ(cursoredPage.bookIds, page.bookIds);
+        EXPECT_EQ(cursoredPage.startIndex, start);
+        EXPECT_EQ(cursoredPage.nextCursor.empty(), start + pageSize >= allBookIds.size());
+        cursoredBookIds.insert(cursoredBookIds.end(), cursoredPage.bookIds.begin(), cursoredPage.bookIds.end());
+        cursor = cursoredPage.nextCursor;
+      }
+      EXPECT_EQ(pagedBookIds, allBookIds);
+      EXPECT_EQ(cursoredBookIds, allBookIds);
+    }
+
+    const auto pastTheEnd = lib->filterPage(f, allBookIds.size() + 5, 10);
+    EXPECT_TRUE(pastTheEnd.bookIds.empty());
+    EXPECT_EQ(pastTheEnd.totalCount, allBookIds.size());
+    EXPECT_EQ(pastTheEnd.nextCursor, "");
+  }
+
+  EXPECT_THROW(lib->filterPageAfter(kiwix::Filter(), "", 10), std::invalid_argument);
+  EXPECT_THROW(lib->filterPageAfter(kiwix::Filter(), "abc", 10), std::invalid_argument);
+  EXPECT_THROW(lib->filterPageAfter(kiwix::Filter(), "12:", 10), std::invalid_argument);
+}
+
+TEST_F(LibraryTest, filterPageAfterIsNotAffectedByRemovalOfPreviousBooks)
+{
+  const auto allBookIds = lib->filter(kiwix::Filter());
+  const auto firstPage = lib->filterPage(kiwix::Filter(), 0, 4);
+  ASSERT_FALSE(firstPage.nextCursor.empty());
+
+  lib->removeBookById(firstPage.bookIds[1]);
+  lib->removeBookById(firstPage.bookIds[3]);
+
+  const auto secondPage = lib->filterPageAfter(kiwix::Filter(), firstPage.nextCursor, 4);
+  EXPECT_EQ(secondPage.bookIds,
+            kiwix::Library::BookIdCollection(allBookIds.begin() + 4, allBookIds.begin() + 8));
+  EXPECT_EQ(secondPage.totalCount, allBookIds.size() - 2);
+}
+
+TEST_F(LibraryTest, sortByTitle)
+{
+  auto bookIds = lib->getBooksIds();
+  lib->sort(bookIds, kiwix::TITLE, true);
+  TitleCollection titles;
+  for ( const auto& bookId : bookIds ) {
+    titles.push_back(lib->getBookById(bookId).getTitle());
+  }
+  EXPECT_EQ(titles, TitleCollection({
+    "An example ZIM archive",
+    "Business talks about TED",
+    "Encyclopédie de la Tunisie",
+    "Encyclopédie de la Tunisie",
+    "Encyclopédie de la Tunisie",
+    "Encyclopédie de la Tunisie",
+    "Géographie par Wikipédia",
+    "Granblue Fantasy Wiki",
+    "Islam Stack Exchange",
+    "Mathématiques",
+    "Movies & TV Stack Exchange",
+    "Mythology & Folklore Stack Exchange",
+    "Ray Charles",
+    "Tania Louis",
+    "TED\"talks\" - Business",
+    "Wikiquote"
+  }));
+
+  auto reversedBookIds = lib->getBooksIds();
+  std::reverse(reversedBookIds.begin(), reversedBookIds.end());
+  lib->sort(reversedBookIds, kiwix::TITLE, false);
+  std::reverse(reversedBookIds.begin(), reversedBookIds.end());
+  // books with the same title keep their relative order
+  EXPECT_EQ(reversedBookIds, bookIds);
+}
+
+TEST_F(LibraryTest, sortBySizeAndDate)
+{
+  auto bookIds = lib->getBooksIds();
+  lib->sort(bookIds, kiwix::SIZE, true);
+  for ( size_t i = 1; i < bookIds.size(); ++i ) {
+    EXPECT_LE(lib->getBookById(bookIds[i-1]).getSize(), lib->getBookById(bookIds[i]).getSize());
+  }
+
+  lib->sort(bookIds, kiwix::DATE, false);
+  for ( size_t i = 1; i < bookIds.size(); ++i ) {
+    EXPECT_GE(lib->getBookById(bookIds[i-1]).getDate(), lib->getBookById(bookIds[i]).getDate());
+  }
+}
+
+TEST_F(LibraryTest, filterPageSortedByValue)
+{
+  const auto largest = lib->filterPage(kiwix::Filter(), 0, 3, kiwix::SIZE, false);
+  EXPECT_EQ(largest.totalCount, 16U);
+  ASSERT_EQ(largest.bookIds.size(), 3U);
+  EXPECT_EQ(ids2Titles({largest.bookIds[0], largest.bookIds[1]}),
+            TitleCollection({"Business talks about TED", "TED\"talks\" - Business"}));
+  EXPECT_EQ(lib->getBookById(largest.bookIds[2]).getTitle(), "Tania Louis");
+  EXPECT_EQ(largest.nextCursor, "");
+
+  const auto f = kiwix::Filter().lang("eng");
+  const auto byDate = lib->filterPage(f, 0, 100, kiwix::DATE, true);
+  EXPECT_EQ(ids2Titles(byDate.bookIds), ids2Titles(lib->filter(f)));
+  for ( size_t i = 1; i < byDate.bookIds.size(); ++i ) {
+    EXPECT_LE(lib->getBookById(byDate.bookIds[i-1]).getDate(),
+              lib->getBookById(byDate.bookIds[i]).getDate());
+  }
+
+  const auto byTitle = lib->filterPage(kiwix::Filter(), 14, 10, kiwix::TITLE, true);
+  EXPECT_EQ(byTitle.totalCount, 16U);
+  EXPECT_EQ(byTitle.startIndex, 14U);
+  EXPECT_EQ(ids2Titles(byTitle.bookIds), TitleCollection({"TED\"talks\" - Business", "Wikiquote"}));
+}
+
 TEST_F(LibraryTest, getBookByPath)
 {
   kiwix::Book book = lib->getBookById(lib->getBooksIds()[0]);
 #ifdef _WIN32
   auto path = "C:\\some\\abs\\path.zim";
+  auto otherPath = "C:\\some\\abs\\other_path.zim";
 #else
   auto path = "/some/abs/path.zim";
+  auto otherPath = "/some/abs/other_path.zim";
 #endif
   book.setPath(path);
   lib->addBook(book);
   EXPECT_EQ(lib->getBookByPath(path).getId(), book.getId());
   EXPECT_THROW(lib->getBookByPath("non/existant/path.zim"), std::out_of_range);
+
+  book.setPath(otherPath);
+  lib->addBook(book);
+  EXPECT_EQ(lib->getBookByPath(otherPath).getId(), book.getId());
+  EXPECT_THROW(lib->getBookByPath(path), std::out_of_range);
+
+  lib->removeBookById(book.getId());
+  EXPECT_THROW(lib->getBookByPath(otherPath), std::out_of_range);
 }
 
 TEST_F(LibraryTest, removeBookByIdRemovesTheBook)
@@ -1243,6 +1480,140 @@ TEST_F(LibraryTest, removeBookByIdUpdatesTheSearchDB)
   EXPECT_THROW(lib->getBookById("raycharles"), std::out_of_range);
 };
 
+TEST_F(LibraryTest, filterResultsAreCachedUntilTheLibraryChanges)
+{
+  kiwix::Filter f;
+  f.lang("fra").name("wikipedia_fr_tunisie");
+  const auto stats0 = lib->getFilterCacheStats();
+
+  const auto result = lib->filter(f);
+  EXPECT_EQ(4U, result.size());
+  const auto stats1 = lib->getFilterCacheStats();
+  EXPECT_EQ(stats1.hits, stats0.hits);
+  EXPECT_EQ(stats1.misses, stats0.misses + 1);
+
+  // The same filter built in a different order hits the cache
+  kiwix::Filter sameFilter;
+  sameFilter.name("wikipedia_fr_tunisie").lang("fra");
+  EXPECT_EQ(result, lib->filter(sameFilter));
+  const auto stats2 = lib->getFilterCacheStats();
+  EXPECT_EQ(stats2.hits, stats1.hits + 1);
+  EXPECT_EQ(stats2.misses, stats1.misses);
+
+  // Any change of the library invalidates the cached results
+  lib->removeBookById(result[0]);
+  EXPECT_EQ(3U, lib->filter(f).size());
+  const auto stats3 = lib->getFilterCacheStats();
+  EXPECT_EQ(stats3.hits, stats2.hits);
+  EXPECT_EQ(stats3.misses, stats2.misses + 1);
+};
+
+TEST_F(LibraryTest, snapshotIsNotAffectedByLaterChanges)
+{
+  const auto snapshot = lib->getSnapshot();
+  EXPECT_EQ(snapshot, lib->getSnapshot());
+  EXPECT_EQ(snapshot->getRevision(), lib->getRevision());
+  EXPECT_EQ(snapshot->getBooksIds(), lib->getBooksIds());
+
+  const auto bookCount = snapshot->getBookCount(true, true);
+  const kiwix::Book& rayCharles = snapshot->getBookById("raycharles");
+  kiwix::Book updatedBook = rayCharles;
+  updatedBook.setTitle("Ray Charles (updated)");
+  lib->addBook(updatedBook);
+  lib->removeBookById("example");
+
+  EXPECT_EQ(rayCharles.getTitle(), "Ray Charles");
+  EXPECT_EQ(bookCount, snapshot->getBookCount(true, true));
+  EXPECT_NO_THROW(snapshot->getBookById("example"));
+
+  const auto newSnapshot = lib->getSnapshot();
+  EXPECT_NE(snapshot, newSnapshot);
+  EXPECT_EQ(newSnapshot->getRevision(), lib->getRevision());
+  EXPECT_EQ(bookCount - 1, newSnapshot->getBookCount(true, true));
+  EXPECT_EQ(newSnapshot->getBookById("raycharles").getTitle(), "Ray Charles (updated)");
+  EXPECT_GT(newSnapshot->getLastUpdatedRevision("raycharles"),
+            snapshot->getLastUpdatedRevision("raycharles"));
+  EXPECT_THROW(newSnapshot->getBookById("example"), std::out_of_range);
+};
+
+TEST_F(LibraryTest, readersDontLockTheLibrary)
+{
+  kiwix::lock_instrumentation::setEnabled(true);
+  kiwix::LockCounters& counters = kiwix::getLockCounters("Library::m_mutex");
+
+  // The snapshot is made by the change itself
+  kiwix::Book updatedBook = lib->getBookById("raycharles");
+  updatedBook.setTitle("Ray Charles (updated)");
+  lib->addBook(updatedBook);
+  const auto acquisitions = counters.getStatistics().acquisitions;
+
+  const auto snapshot = lib->getSnapshot();
+  EXPECT_EQ(snapshot->getRevision(), lib->getRevision());
+  EXPECT_EQ(snapshot->getBookById("raycharles").getTitle(), "Ray Charles (updated)");
+  EXPECT_EQ(lib->getBookPtrById("raycharles")->getTitle(), "Ray Charles (updated)");
+  EXPECT_EQ(lib->getBooksIds(), snapshot->getBooksIds());
+  EXPECT_EQ(lib->filter(kiwix::Filter()), snapshot->getBooksIds());
+  EXPECT_EQ(lib->filterPage(kiwix::Filter().remote(true), 0, 2).bookIds.size(), 2U);
+  EXPECT_EQ(counters.getStatistics().acquisitions, acquisitions);
+
+  lib->removeBookById("example");
+  EXPECT_GT(counters.getStatistics().acquisitions, acquisitions);
+  EXPECT_NE(lib->getSnapshot(), snapshot);
+  EXPECT_THROW(lib->getSnapshot()->getBookById("example"), std::out_of_range);
+
+  kiwix::lock_instrumentation::setEnabled(false);
+};
+
+TEST_F(LibraryTest, getBookPtrById)
+{
+  const auto book = lib->getBookPtrById("raycharles");
+  EXPECT_EQ(book->getTitle(), "Ray Charles");
+  EXPECT_EQ(book, lib->getBookPtrById("raycharles"));
+  EXPECT_THROW(lib->getBookPtrById("nosuchbook"), std::out_of_range);
+
+  kiwix::Book updatedBook = *book;
+  updatedBook.setTitle("Ray Charles (updated)");
+  lib->addBook(updatedBook);
+  lib->removeBookById("raycharles");
+
+  // The book is shared, not copied, but never modified
+  EXPECT_EQ(book->getTitle(), "Ray Charles");
+  EXPECT_THROW(lib->getBookPtrById("raycharles"), std::out_of_range);
+};
+
+TEST_F(LibraryTest, addBooksAndRemoveBooksByIds)
+{
+  const auto initialBookCount = lib->getBookCount(true, true);
+  kiwix::Book updatedBook = lib->getBookByIdThreadSafe("raycharles");
+  updatedBook.setTitle("Ray Charles Fans");
+  kiwix::Book newBook1 = updatedBook;
+  newBook1.setId("newbook1");
+  newBook1.setTitle("Stevie Wonder");
+  kiwix::Book newBook2 = newBook1;
+  newBook2.setId("newbook2");
+
+  const auto rev = lib->getRevision();
+  const auto addedBookIds = lib->addBooks({newBook1, updatedBook, newBook2});
+  EXPECT_EQ(addedBookIds, kiwix::Library::BookIdCollection({"newbook1", "newbook2"}));
+  EXPECT_EQ(rev + 1, lib->getRevision());
+  EXPECT_EQ(initialBookCount + 2, lib->getBookCount(true, true));
+  EXPECT_EQ(lib->getBookById("raycharles").getTitle(), "Ray Charles Fans");
+  EXPECT_EQ(2U, lib->filter(kiwix::Filter().query("stevie")).size());
+
+  EXPECT_EQ(2U, lib->removeBooksByIds({"newbook1", "nosuchbook", "raycharles"}));
+  EXPECT_EQ(rev + 2, lib->getRevision());
+  EXPECT_EQ(initialBookCount - 1, lib->getBookCount(true, true));
+  EXPECT_EQ(lib->filter(kiwix::Filter().query("stevie")),
+            kiwix::Library::BookIdCollection({"newbook2"}));
+
+  EXPECT_EQ(0U, lib->removeBooksByIds({"newbook1", "nosuchbook"}));
+  EXPECT_EQ(rev + 2, lib->getRevision());
+
+  // Adding an empty batch of books doesn't change the library
+  EXPECT_TRUE(lib->addBooks({}).empty());
+  EXPECT_EQ(rev + 2, lib->getRevision());
+};
+
 TEST_F(LibraryTest, removeBooksNotUpdatedSince)
 {
   EXPECT_FILTER_RESULTS(kiwix::Filter(),
@@ -1284,4 +1655,92 @@ TEST_F(LibraryTest, removeBooksNotUpdatedSince)
   );
 };
 
+TEST(LibraryFilterTest, booksSelectedWithoutTextQueryAreInTheOrderOfAddition)
+{
+  const auto lib = kiwix::Library::create();
+  const std::vector<std::pair<std::string, std::string>> idsAndLangs{
+    {"c", "eng"}, {"a", "eng,fra,eng"}, {"d", "fra"}, {"b", "eng"}
+  };
+  for ( const auto& idAndLang : idsAndLangs ) {
+    kiwix::Book book;
+    book.setId(idAndLang.first);
+    book.setLanguage(idAndLang.second);
+    lib->addBook(book);
+  }
+
+  const auto f = kiwix::Filter().lang("eng");
+  EXPECT_EQ(lib->filter(f), kiwix::Library::BookIdCollection({"c", "a", "b"}));
+  EXPECT_EQ(lib->filterPage(f, 1, 1).bookIds, kiwix::Library::BookIdCollection({"a"}));
+  EXPECT_EQ(lib->filterPage(f, 1, 1).totalCount, 3U);
+}
+
+TEST(OPDSEntryCacheTest, entriesAreRenderedAgainAfterBookUpdates)
+{
+  const auto lib = kiwix::Library::create();
+  kiwix::Book book;
+  book.setId("0123456789");
+  book.setTitle("Old title");
+  book.setDate("2024-01-01");
+  lib->addBook(book);
+
+  const kiwix::IdNameMapper nameMapper;
+  kiwix::OPDSDumper dumper(lib.get(), &nameMapper);
+  dumper.setRootLocation("/ROOT");
+  dumper.setContentAccessUrl("/ROOT/content");
+  kiwix::OPDSDumper cachingDumper(dumper);
+  cachingDumper.setEntryCache(std::make_shared<kiwix::OPDSEntryCache>(10));
+
+  const std::vector<std::string> ids{"0123456789"};
+  const auto entries = dumper.dumpOPDSEntries(ids, false);
+  EXPECT_NE(entries.find("<title>Old title</title>"), std::string::npos);
+  EXPECT_EQ(cachingDumper.dumpOPDSEntries(ids, false), entries);
+  EXPECT_EQ(cachingDumper.dumpOPDSEntries(ids, false), entries);
+  EXPECT_EQ(cachingDumper.dumpOPDSEntries(ids, true),
+            dumper.dumpOPDSEntries(ids, true));
+
+  book.setTitle("New title");
+  lib->addBook(book);
+  const auto updatedEntries = cachingDumper.dumpOPDSEntries(ids, false);
+  EXPECT_NE(updatedEntries.find("<title>New title</title>"), std::string::npos);
+  EXPECT_EQ(updatedEntries, dumper.dumpOPDSEntries(ids, false));
+
+  lib->removeBookById("0123456789");
+  EXPECT_EQ(cachingDumper.dumpOPDSEntries(ids, false), "");
+}
+
+TEST(OPDSDumperTest, entriesOfLargeFeedsAreInOrder)
+{
+  const auto lib = kiwix::Library::create();
+  std::vector<std::string> ids;
+  for ( int i = 0; i < 1000; ++i ) {
+    kiwix::Book book;
+    book.setId("book" + std::to_string(i));
+    book.setTitle("Book #" + std::to_string(i));
+    lib->addBook(book);
+    ids.push_back(book.getId());
+  }
+
+  const kiwix::IdNameMapper nameMapper;
+  kiwix::OPDSDumper dumper(lib.get(), &nameMapper);
+  std::string expectedEntries;
+  for ( const auto& id : ids ) {
+    expectedEntries += dumper.dumpOPDSEntries({id}, false);
+  }
+  EXPECT_EQ(dumper.dumpOPDSEntries(ids, false), expectedEntries);
+
+  kiwix::OPDSDumper parallelDumper(dumper);
+  parallelDumper.setRenderingPool(std::make_shared<kiwix::WorkerPool>(3));
+  EXPECT_EQ(parallelDumper.dumpOPDSEntries(ids, false), expectedEntries);
+
+  // Only the entries missing from the cache are rendered in parallel, the
+  // others are taken from the cache
+  parallelDumper.setEntryCache(std::make_shared<kiwix::OPDSEntryCache>(2000));
+  for ( size_t i = 0; i < ids.size(); i += 3 ) {
+    parallelDumper.dumpOPDSEntries({ids[i]}, false);
+  }
+  EXPECT_EQ(parallelDumper.dumpOPDSEntries(ids, false), expectedEntries);
+  // All the entries are cached now
+  EXPECT_EQ(parallelDumper.dumpOPDSEntries(ids, false), expectedEntries);
+}
+
 };
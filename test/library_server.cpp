@@ -6,6 +6,19 @@
 #define SERVER_PORT 8001
 #include "server_testing_tools.h"
 
+#include "../src/tools/pathTools.h"
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
 ////////////////////////////////////////////////////////////////////////////////
 // Testing of the library-related functionality of the server
 ////////////////////////////////////////////////////////////////////////////////
@@ -361,8 +374,8 @@ TEST_F(LibraryServerTest, catalog_search_by_category)
       "  <startIndex>0</startIndex>\n"
       "  <itemsPerPage>2</itemsPerPage>\n"
       CATALOG_LINK_TAGS
-      CHARLES_RAY_CATALOG_ENTRY
       RAY_CHARLES_CATALOG_ENTRY
+      CHARLES_RAY_CATALOG_ENTRY
       "</feed>\n"
     );
   }
@@ -382,8 +395,8 @@ TEST_F(LibraryServerTest, catalog_search_by_language)
       "  <startIndex>0</startIndex>\n"
       "  <itemsPerPage>2</itemsPerPage>\n"
       CATALOG_LINK_TAGS
-      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
       RAY_CHARLES_CATALOG_ENTRY
+      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
       "</feed>\n"
     );
   }
@@ -400,9 +413,9 @@ TEST_F(LibraryServerTest, catalog_search_by_language)
       "  <startIndex>0</startIndex>\n"
       "  <itemsPerPage>3</itemsPerPage>\n"
       CATALOG_LINK_TAGS
-      CHARLES_RAY_CATALOG_ENTRY
-      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
       RAY_CHARLES_CATALOG_ENTRY
+      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
+      CHARLES_RAY_CATALOG_ENTRY
       "</feed>\n"
     );
   }
@@ -727,6 +740,211 @@ TEST_F(LibraryServerTest, catalog_v2_entries)
   );
 }
 
+// Opens a connection to the test server and sends a request to it without
+// reading the response
+int sendRawRequest(int port, const std::string& url, const std::string& extraHeaders = "")
+{
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if ( fd < 0 || connect(fd, (const sockaddr*)&addr, sizeof(addr)) != 0 ) {
+    throw std::runtime_error("Cannot connect to the test server");
+  }
+  const std::string request = "GET " + url + " HTTP/1.1\r\n"
+                              "Host: 127.0.0.1\r\n"
+                              "Connection: close\r\n"
+                            + extraHeaders
+                            + "\r\n";
+  if ( send(fd, request.data(), request.size(), 0) != ssize_t(request.size()) ) {
+    close(fd);
+    throw std::runtime_error("Cannot send the request to the test server");
+  }
+  return fd;
+}
+
+std::string readUntilEOF(int fd)
+{
+  std::string data;
+  char buf[4096];
+  ssize_t n;
+  while ( (n = recv(fd, buf, sizeof(buf), 0)) > 0 ) {
+    data.append(buf, n);
+  }
+  return data;
+}
+
+// Returns the body of a raw HTTP response using the chunked transfer encoding
+std::string dechunk(const std::string& response)
+{
+  std::string body;
+  size_t pos = response.find("\r\n\r\n");
+  if ( pos == std::string::npos ) {
+    throw std::runtime_error("Incomplete HTTP response headers");
+  }
+  pos += 4;
+  while ( true ) {
+    const size_t chunkSizeEnd = response.find("\r\n", pos);
+    if ( chunkSizeEnd == std::string::npos ) {
+      throw std::runtime_error("Truncated chunked body");
+    }
+    const size_t chunkSize = std::stoul(response.substr(pos, chunkSizeEnd - pos), nullptr, 16);
+    pos = chunkSizeEnd + 2;
+    if ( chunkSize == 0 ) {
+      return body;
+    }
+    if ( pos + chunkSize + 2 > response.size() ) {
+      throw std::runtime_error("Truncated chunk");
+    }
+    body.append(response, pos, chunkSize);
+    pos += chunkSize + 2;
+  }
+}
+
+// Inflates a complete gzip stream
+std::string gunzip(const std::string& data)
+{
+  z_stream strm{};
+  if ( inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK ) {
+    throw std::runtime_error("inflateInit2() failed");
+  }
+  strm.next_in = (Bytef*)data.data();
+  strm.avail_in = data.size();
+  std::string result;
+  char buf[16384];
+  int ret;
+  do {
+    strm.next_out = (Bytef*)buf;
+    strm.avail_out = sizeof(buf);
+    ret = inflate(&strm, Z_NO_FLUSH);
+    result.append(buf, sizeof(buf) - strm.avail_out);
+  } while ( ret == Z_OK );
+  const bool complete = ret == Z_STREAM_END && strm.avail_in == 0;
+  inflateEnd(&strm);
+  if ( !complete ) {
+    throw std::runtime_error("Invalid or truncated gzip stream");
+  }
+  return result;
+}
+
+TEST_F(LibraryServerTest, catalog_v2_entries_streamed)
+{
+  const std::string expectedOPDS =
+    CATALOG_V2_ENTRIES_PREAMBLE("")
+    "  <title>All Entries</title>\n"
+    "  <updated>YYYY-MM-DDThh:mm:ssZ</updated>\n"
+    "\n"
+    CHARLES_RAY_CATALOG_ENTRY
+    RAY_CHARLES_CATALOG_ENTRY
+    UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
+    "</feed>\n";
+
+  ZimFileServer::Cfg serverCfg;
+  serverCfg.opdsStreamingThreshold = 1;
+  resetServer(serverCfg);
+
+  const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/entries");
+  const auto g = zfs1_->GET("/ROOT%23%3F/catalog/v2/entries", { {"Accept-Encoding", "gzip"} });
+  // httplib inflates the body of g but doesn't check that the gzip stream
+  // is complete, hence the raw request
+  const int fd = sendRawRequest(PORT, "/ROOT%23%3F/catalog/v2/entries", "Accept-Encoding: gzip\r\n");
+  const std::string rawGzipResponse = readUntilEOF(fd);
+  close(fd);
+
+  EXPECT_EQ(r->status, 200);
+  EXPECT_EQ(r->get_header_value("Transfer-Encoding"), "chunked");
+  EXPECT_FALSE(r->has_header("Content-Length"));
+  EXPECT_EQ(maskVariableOPDSFeedData(r->body), expectedOPDS);
+
+  EXPECT_EQ(g->status, 200);
+  EXPECT_EQ(g->get_header_value("Transfer-Encoding"), "chunked");
+  EXPECT_EQ(g->get_header_value("Content-Encoding"), "gzip");
+  EXPECT_EQ(g->get_header_value("Vary"), "Accept-Encoding");
+  EXPECT_EQ(maskVariableOPDSFeedData(g->body), expectedOPDS);
+  EXPECT_EQ(maskVariableOPDSFeedData(gunzip(dechunk(rawGzipResponse))), expectedOPDS);
+}
+
+// Writes a library.xml file describing bookCount books (without ZIM files)
+// into a new temporary directory and returns the path of that directory
+std::string makeLargeLibraryDirectory(size_t bookCount)
+{
+  std::string xml = "<library version=\"1.0\">\n";
+  for ( size_t i = 0; i < bookCount; ++i ) {
+    const std::string id = "book" + std::to_string(i);
+    xml += "<book id=\"" + id + "\" path=\"" + id + ".zim\""
+           " url=\"https://example.com/" + id + ".zim\""
+           " title=\"Book " + std::to_string(i) + "\""
+           " description=\"Book number " + std::to_string(i) + "\""
+           " language=\"eng\" tags=\"unittest\"/>\n";
+  }
+  xml += "</library>\n";
+  const std::string dir = makeTmpDirectory();
+  if ( !writeTextFile(kiwix::appendToDirectory(dir, "library.xml"), xml) ) {
+    throw std::runtime_error("Cannot write the library file");
+  }
+  return dir;
+}
+
+TEST_F(LibraryServerTest, catalog_v2_entries_streamed_to_closed_connection)
+{
+  const std::string dir = makeLargeLibraryDirectory(20000);
+  const std::string libraryPath = kiwix::appendToDirectory(dir, "library.xml");
+
+  zfs1_.reset();
+  zfs1_.reset(new ZimFileServer(PORT, ZimFileServer::CATALOG_ONLY_MODE, libraryPath));
+
+  // The client goes away after receiving the beginning of the feed. The
+  // server must notice it and stop producing the feed (with only two
+  // threads, a server busy with dead requests would not answer the requests
+  // below).
+  for ( int i = 0; i < 4; ++i ) {
+    const int fd = sendRawRequest(PORT, "/ROOT%23%3F/catalog/v2/entries?count=-1");
+    char buf[1024];
+    EXPECT_GT(recv(fd, buf, sizeof(buf), 0), 0);
+    close(fd);
+  }
+
+  const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/entries?count=1");
+  EXPECT_EQ(r->status, 200);
+  EXPECT_NE(r->body.find("<totalResults>20000</totalResults>"), std::string::npos);
+
+  const auto all = zfs1_->GET("/ROOT%23%3F/catalog/v2/entries?count=-1");
+  EXPECT_EQ(all->status, 200);
+  EXPECT_EQ(all->get_header_value("Transfer-Encoding"), "chunked");
+  EXPECT_NE(all->body.find("<id>urn:uuid:book19999</id>"), std::string::npos);
+
+  zfs1_.reset();
+  std::filesystem::remove_all(dir);
+}
+
+TEST_F(LibraryServerTest, no_js_page_for_closed_connection)
+{
+  const std::string dir = makeLargeLibraryDirectory(20000);
+  const std::string libraryPath = kiwix::appendToDirectory(dir, "library.xml");
+
+  zfs1_.reset();
+  testing::internal::CaptureStdout();
+  zfs1_.reset(new ZimFileServer(PORT,
+                                ZimFileServer::Options(ZimFileServer::CATALOG_ONLY_MODE | ZimFileServer::VERBOSE),
+                                libraryPath));
+
+  // The client closes the connection (cleanly, since nothing was sent to it
+  // yet) while the page listing all the books is being built. The server
+  // must stop building it.
+  const int fd = sendRawRequest(PORT, "/ROOT%23%3F/nojs");
+  close(fd);
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  zfs1_.reset();
+  const std::string output = testing::internal::GetCapturedStdout();
+
+  EXPECT_NE(output.find("Request cancelled (client disconnected)"), std::string::npos);
+  EXPECT_EQ(output.find("Request time"), std::string::npos);
+
+  std::filesystem::remove_all(dir);
+}
+
+
 TEST_F(LibraryServerTest, catalog_v2_entries_catalog_only_mode)
 {
   const std::string contentServerUrl = "https://demo.kiwix.org";
@@ -770,6 +988,115 @@ TEST_F(LibraryServerTest, catalog_v2_entries_catalog_only_mode)
   }
 }
 
+// Removes the link to the content of the book from an OPDS entry. An entry
+// without illustrations keeps a whitespace-only line in its place (as the
+// mustache template used for rendering the entries did).
+std::string removeContentLink(const std::string& entry, bool withIllustrations)
+{
+  const std::regex contentLink("    <link type=\"text/html\" href=\"[^\"]*\" />\n");
+  return std::regex_replace(entry, contentLink, withIllustrations ? "" : "    \n");
+}
+
+TEST_F(LibraryServerTest, catalog_v2_entries_catalog_only_mode_without_content_server)
+{
+  resetServer(ZimFileServer::CATALOG_ONLY_MODE);
+  const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/entries");
+  EXPECT_EQ(r->status, 200);
+  EXPECT_EQ(maskVariableOPDSFeedData(r->body),
+    CATALOG_V2_ENTRIES_PREAMBLE("")
+    "  <title>All Entries</title>\n"
+    "  <updated>YYYY-MM-DDThh:mm:ssZ</updated>\n"
+    "\n"
+    + removeContentLink(CHARLES_RAY_CATALOG_ENTRY, false)
+    + removeContentLink(INACCESSIBLEZIMFILE_CATALOG_ENTRY, false)
+    + removeContentLink(RAY_CHARLES_CATALOG_ENTRY, true)
+    + removeContentLink(UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY, false) +
+    "</feed>\n"
+  );
+}
+
+TEST_F(LibraryServerTest, catalog_v2_entries_of_books_without_url)
+{
+  const std::string dir = makeTmpDirectory();
+  const std::string libraryPath = kiwix::appendToDirectory(dir, "library.xml");
+  ASSERT_TRUE(writeTextFile(libraryPath,
+    "<library version=\"1.0\">\n"
+    "  <book id=\"nourl\" path=\"./nourl.zim\" title=\"No URL\""
+         " description=\"A book that can't be downloaded\" language=\"eng\""
+         " creator=\"Nobody\" publisher=\"Kiwix\" date=\"2020-03-31\""
+         " name=\"nourl\" tags=\"unittest\" articleCount=\"1\" mediaCount=\"0\""
+         " size=\"1\"/>\n"
+    "  <book id=\"nourl_illustrated\" path=\"./nourl_illustrated.zim\""
+         " title=\"No URL (illustrated)\""
+         " description=\"A book that can't be downloaded\" language=\"eng\""
+         " creator=\"Nobody\" publisher=\"Kiwix\" date=\"2020-03-31\""
+         " name=\"nourl_illustrated\" tags=\"unittest\" articleCount=\"1\""
+         " mediaCount=\"0\" size=\"1\""
+         " faviconMimeType=\"image/png\" favicon=\"SOME DATA\"/>\n"
+    "</library>\n"));
+
+  zfs1_.reset();
+  zfs1_.reset(new ZimFileServer(PORT, ZimFileServer::CATALOG_ONLY_MODE, libraryPath));
+  const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/entries");
+  zfs1_.reset();
+  std::filesystem::remove_all(dir);
+
+  EXPECT_EQ(r->status, 200);
+  EXPECT_EQ(maskVariableOPDSFeedData(r->body),
+    CATALOG_V2_ENTRIES_PREAMBLE("")
+    "  <title>All Entries</title>\n"
+    "  <updated>YYYY-MM-DDThh:mm:ssZ</updated>\n"
+    "\n"
+    "  <entry>\n"
+    "    <id>urn:uuid:nourl</id>\n"
+    "    <title>No URL</title>\n"
+    "    <updated>YYYY-MM-DDThh:mm:ssZ</updated>\n"
+    "    <summary>A book that can&apos;t be downloaded</summary>\n"
+    "    <language>eng</language>\n"
+    "    <name>nourl</name>\n"
+    "    <flavour></flavour>\n"
+    "    <category></category>\n"
+    "    <tags>unittest</tags>\n"
+    "    <articleCount>1</articleCount>\n"
+    "    <mediaCount>0</mediaCount>\n"
+    "    \n"
+    "    <author>\n"
+    "      <name>Nobody</name>\n"
+    "    </author>\n"
+    "    <publisher>\n"
+    "      <name>Kiwix</name>\n"
+    "    </publisher>\n"
+    "    <dc:issued>2020-03-31T00:00:00Z</dc:issued>\n"
+    "    \n"
+    "  </entry>\n"
+    "  <entry>\n"
+    "    <id>urn:uuid:nourl_illustrated</id>\n"
+    "    <title>No URL (illustrated)</title>\n"
+    "    <updated>YYYY-MM-DDThh:mm:ssZ</updated>\n"
+    "    <summary>A book that can&apos;t be downloaded</summary>\n"
+    "    <language>eng</language>\n"
+    "    <name>nourl_illustrated</name>\n"
+    "    <flavour></flavour>\n"
+    "    <category></category>\n"
+    "    <tags>unittest</tags>\n"
+    "    <articleCount>1</articleCount>\n"
+    "    <mediaCount>0</mediaCount>\n"
+    "    <link rel=\"http://opds-spec.org/image/thumbnail\"\n"
+    "          href=\"/ROOT%23%3F/catalog/v2/illustration/nourl_illustrated/?size=48\"\n"
+    "          type=\"image/png;width=48;height=48;scale=1\"/>\n"
+    "    <author>\n"
+    "      <name>Nobody</name>\n"
+    "    </author>\n"
+    "    <publisher>\n"
+    "      <name>Kiwix</name>\n"
+    "    </publisher>\n"
+    "    <dc:issued>2020-03-31T00:00:00Z</dc:issued>\n"
+    "    \n"
+    "  </entry>\n"
+    "</feed>\n"
+  );
+}
+
 TEST_F(LibraryServerTest, catalog_v2_entries_filtered_by_range)
 {
   {
@@ -1043,8 +1370,8 @@ TEST_F(LibraryServerTest, catalog_v2_entries_filtered_by_language)
       "  <totalResults>2</totalResults>\n"
       "  <startIndex>0</startIndex>\n"
       "  <itemsPerPage>2</itemsPerPage>\n"
-      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
       RAY_CHARLES_CATALOG_ENTRY
+      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
       "</feed>\n"
     );
   }
@@ -1059,9 +1386,9 @@ TEST_F(LibraryServerTest, catalog_v2_entries_filtered_by_language)
       "  <totalResults>3</totalResults>\n"
       "  <startIndex>0</startIndex>\n"
       "  <itemsPerPage>3</itemsPerPage>\n"
-      CHARLES_RAY_CATALOG_ENTRY
-      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
       RAY_CHARLES_CATALOG_ENTRY
+      UNCATEGORIZED_RAY_CHARLES_CATALOG_ENTRY
+      CHARLES_RAY_CATALOG_ENTRY
       "</feed>\n"
     );
   }
@@ -1094,8 +1421,8 @@ TEST_F(LibraryServerTest, catalog_v2_entries_filtered_by_category)
       "  <totalResults>2</totalResults>\n"
       "  <startIndex>0</startIndex>\n"
       "  <itemsPerPage>2</itemsPerPage>\n"
-      CHARLES_RAY_CATALOG_ENTRY
       RAY_CHARLES_CATALOG_ENTRY
+      CHARLES_RAY_CATALOG_ENTRY
       "</feed>\n"
     );
   }
@@ -1132,6 +1459,155 @@ TEST_F(LibraryServerTest, catalog_v2_individual_entry_access)
   EXPECT_EQ(r1->status, 404);
 }
 
+#define RAY_CHARLES_JSON_ENTRY                                              \
+  "{\"id\":\"raycharles\","                                                 \
+  "\"name\":\"wikipedia_en_ray_charles\","                                  \
+  "\"title\":\"Ray Charles\","                                              \
+  "\"description\":\"Wikipedia articles about Ray Charles (not all of them but near to what an average newborn may find more than enough)\"," \
+  "\"languages\":[\"eng\"],"                                                \
+  "\"category\":\"wikipedia\","                                             \
+  "\"flavour\":\"\","                                                       \
+  "\"tags\":\"public_tag_without_a_value;_private_tag_without_a_value;wikipedia;_category:wikipedia;_pictures:no;_videos:no;_details:no;_ftindex:yes\"," \
+  "\"articleCount\":284,"                                                   \
+  "\"mediaCount\":2,"                                                       \
+  "\"size\":569344,"                                                        \
+  "\"date\":\"2020-03-31\","                                                \
+  "\"creator\":\"Wikipedia\","                                              \
+  "\"publisher\":\"Kiwix\","                                                \
+  "\"illustrations\":[{\"width\":48,\"height\":48,\"mimeType\":\"image/png\",\"url\":\"/ROOT%23%3F/catalog/v2/illustration/raycharles/?size=48\"}]," \
+  "\"contentUrl\":\"/ROOT%23%3F/content/zimfile_raycharles\","              \
+  "\"downloadUrl\":\"https://github.com/kiwix/libkiwix/raw/master/test/data/zimfile_raycharles.zim\"}"
+
+TEST_F(LibraryServerTest, catalog_v2_json)
+{
+  const std::string jsonMimeType = "application/json; charset=utf-8";
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/entry/raycharles?format=json");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->get_header_value("Content-Type"), jsonMimeType);
+    EXPECT_EQ(r->body, RAY_CHARLES_JSON_ENTRY "\n");
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/entries?format=json&lang=eng&category=wikipedia");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->get_header_value("Content-Type"), jsonMimeType);
+    EXPECT_EQ(r->body,
+      "{\"totalResults\":1,\"startIndex\":0,\"itemsPerPage\":1,"
+      "\"entries\":[" RAY_CHARLES_JSON_ENTRY "]}\n"
+    );
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/partial_entries?format=json&start=1");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->body,
+      "{\"totalResults\":3,\"startIndex\":1,\"itemsPerPage\":2,"
+      "\"entries\":["
+        "{\"id\":\"raycharles\",\"title\":\"Ray Charles\",\"date\":\"2020-03-31\"},"
+        "{\"id\":\"raycharles_uncategorized\",\"title\":\"Ray (uncategorized) Charles\",\"date\":\"2020-03-31\"}"
+      "]}\n"
+    );
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/partial_entries?format=json&count=1");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->body,
+      "{\"totalResults\":3,\"startIndex\":0,\"itemsPerPage\":1,"
+      "\"nextCursor\":\"1:charlesray\","
+      "\"entries\":["
+        "{\"id\":\"charlesray\",\"title\":\"Charles, Ray\",\"date\":\"2020-03-31\"}"
+      "]}\n"
+    );
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/partial_entries?format=json&count=1&cursor=1%3Acharlesray");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->body,
+      "{\"totalResults\":3,\"startIndex\":1,\"itemsPerPage\":1,"
+      "\"nextCursor\":\"2:raycharles\","
+      "\"entries\":["
+        "{\"id\":\"raycharles\",\"title\":\"Ray Charles\",\"date\":\"2020-03-31\"}"
+      "]}\n"
+    );
+  }
+  {
+    // Malformed cursors and cursors combined with sorting are rejected
+    const char* const urls[] = {
+      "/ROOT%23%3F/catalog/v2/partial_entries?format=json&count=1&cursor=charlesray",
+      "/ROOT%23%3F/catalog/v2/partial_entries?format=json&count=1&cursor=1%3A",
+      "/ROOT%23%3F/catalog/v2/entries?count=1&cursor=x1%3Acharlesray",
+      "/ROOT%23%3F/catalog/search?count=1&cursor=abc",
+      "/ROOT%23%3F/catalog/v2/partial_entries?format=json&count=1&cursor=1%3Acharlesray&sort=title",
+    };
+    for ( const char* url : urls ) {
+      EXPECT_EQ(zfs1_->GET(url)->status, 400) << url;
+    }
+  }
+  {
+    // Invalid dates and sizes are rejected
+    const char* const urls[] = {
+      "/ROOT%23%3F/catalog/v2/partial_entries?format=json&datefrom=abc",
+      "/ROOT%23%3F/catalog/v2/entries?dateto=2023-1",
+      "/ROOT%23%3F/catalog/v2/entries?minsize=abc",
+      "/ROOT%23%3F/catalog/v2/entries?minsize=-1",
+      "/ROOT%23%3F/catalog/search?maxsize=1x",
+      "/ROOT%23%3F/nojs?datefrom=2020-13",
+    };
+    for ( const char* url : urls ) {
+      EXPECT_EQ(zfs1_->GET(url)->status, 400) << url;
+    }
+  }
+  {
+    // Unknown sort keys are rejected
+    const char* const urls[] = {
+      "/ROOT%23%3F/catalog/v2/partial_entries?format=json&sort=foo",
+      "/ROOT%23%3F/catalog/v2/entries?sort=-",
+      "/ROOT%23%3F/catalog/v2/entries?sort=-foo",
+      "/ROOT%23%3F/catalog/search?sort=Title",
+      "/ROOT%23%3F/nojs?sort=foo",
+    };
+    for ( const char* url : urls ) {
+      EXPECT_EQ(zfs1_->GET(url)->status, 400) << url;
+    }
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/partial_entries?format=json&sort=-title&count=2");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->body,
+      "{\"totalResults\":3,\"startIndex\":0,\"itemsPerPage\":2,"
+      "\"entries\":["
+        "{\"id\":\"raycharles\",\"title\":\"Ray Charles\",\"date\":\"2020-03-31\"},"
+        "{\"id\":\"raycharles_uncategorized\",\"title\":\"Ray (uncategorized) Charles\",\"date\":\"2020-03-31\"}"
+      "]}\n"
+    );
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/partial_entries?format=json&datefrom=2020-04");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->body,
+      "{\"totalResults\":0,\"startIndex\":0,\"itemsPerPage\":0,\"entries\":[]}\n"
+    );
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/categories?format=json");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->get_header_value("Content-Type"), jsonMimeType);
+    EXPECT_EQ(r->body, "{\"categories\":[\"cats\",\"jazz\",\"wikipedia\"]}\n");
+  }
+  {
+    const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/languages?format=json");
+    EXPECT_EQ(r->status, 200);
+    EXPECT_EQ(r->get_header_value("Content-Type"), jsonMimeType);
+    EXPECT_EQ(r->body,
+      "{\"languages\":["
+        "{\"code\":\"cat\",\"selfName\":\"català\",\"bookCount\":1},"
+        "{\"code\":\"eng\",\"selfName\":\"English\",\"bookCount\":2},"
+        "{\"code\":\"fra\",\"selfName\":\"français\",\"bookCount\":1},"
+        "{\"code\":\"rus\",\"selfName\":\"русский\",\"bookCount\":1}"
+      "]}\n"
+    );
+  }
+}
+
 TEST_F(LibraryServerTest, catalog_v2_partial_entries)
 {
   const auto r = zfs1_->GET("/ROOT%23%3F/catalog/v2/partial_entries");
@@ -1547,12 +2023,24 @@ TEST_F(LibraryServerTest, noJS) {
             FINAL_HTML_TEXT);
 
   // no_js_eng_lang
-  r = zfs1_->GET("/ROOT%23%3F/nojs?lang=eng");
+  r = zfs1_->GET("/ROOT%23%3F/nojs");
   EXPECT_EQ(r->status, 200);
   EXPECT_EQ(r->body,
             HTML_PREAMBLE
             FILTERS_HTML(" selected ")
             HOME_BODY_TEXT("2")
+            RAY_CHARLES_BOOK_HTML
+            RAY_CHARLES_UNCTZ_BOOK_HTML
+            FINAL_HTML_TEXT);
+
+  // no_js_sorted_by_title
+  r = zfs1_->GET("/ROOT%23%3F/nojs?sort=title");
+  EXPECT_EQ(r->status, 200);
+  EXPECT_EQ(r->body,
+            HTML_PREAMBLE
+            FILTERS_HTML("")
+            HOME_BODY_TEXT("3")
+            CHARLES_RAY_BOOK_HTML
             RAY_CHARLES_UNCTZ_BOOK_HTML
             RAY_CHARLES_BOOK_HTML
             FINAL_HTML_TEXT);
@@ -31,8 +31,13 @@
 
 #include "../src/tools/lrucache.h"
 #include "../src/tools/concurrent_cache.h"
+#include "../src/tools/instrumented_lock.h"
 #include "gtest/gtest.h"
 
+#include <condition_variable>
+#include <future>
+#include <thread>
+
 const unsigned int NUM_OF_TEST2_RECORDS = 100;
 const unsigned int TEST2_CACHE_CAPACITY = 50;
 
@@ -107,6 +112,31 @@ TEST(ConcurrentCacheTest, handleException) {
     EXPECT_EQ(val, 888);
 }
 
+TEST(ConcurrentCacheTest, getIfReady) {
+    kiwix::ConcurrentCache<int, int> cache(2);
+    int val = 0;
+    EXPECT_FALSE(cache.getIfReady(7, val));
+    cache.getOrPut(7, []() { return 777; });
+    EXPECT_TRUE(cache.getIfReady(7, val));
+    EXPECT_EQ(val, 777);
+
+    // An entry being generated is not ready
+    std::promise<void> generationStarted, generationAllowed;
+    auto generation = std::async(std::launch::async, [&]() {
+        return cache.getOrPut(8, [&]() {
+            generationStarted.set_value();
+            generationAllowed.get_future().wait();
+            return 888;
+        });
+    });
+    generationStarted.get_future().wait();
+    EXPECT_FALSE(cache.getIfReady(8, val));
+    generationAllowed.set_value();
+    EXPECT_EQ(generation.get(), 888);
+    EXPECT_TRUE(cache.getIfReady(8, val));
+    EXPECT_EQ(val, 888);
+}
+
 TEST(ConcurrentCacheTest, weakPtr) {
     kiwix::ConcurrentCache<int, std::shared_ptr<int>> cache(1);
     auto refValue = cache.getOrPut(7, []() { return std::make_shared<int>(777); });
@@ -128,3 +158,102 @@ TEST(ConcurrentCacheTest, weakPtr) {
     // Be sure we call the construction function
     EXPECT_THROW(cache.getOrPut(7, []() { throw std::runtime_error("oups"); return nullptr; }), std::runtime_error);
 }
+
+TEST(LockCountersTest, accumulate) {
+    kiwix::LockCounters& counters = kiwix::getLockCounters("LockCountersTest");
+    EXPECT_EQ(&counters, &kiwix::getLockCounters("LockCountersTest"));
+
+    counters.recordAcquisition(0, false);
+    counters.recordRelease(100);
+    counters.recordAcquisition(30, true);
+    counters.recordRelease(50);
+    counters.recordAcquisition(20, true);
+    counters.recordRelease(10);
+
+    auto stats = counters.getStatistics();
+    EXPECT_EQ(stats.name, "LockCountersTest");
+    EXPECT_EQ(stats.acquisitions, 3U);
+    EXPECT_EQ(stats.contentions, 2U);
+    EXPECT_EQ(stats.totalWaitNs, 50U);
+    EXPECT_EQ(stats.maxWaitNs, 30U);
+    EXPECT_EQ(stats.totalHoldNs, 160U);
+    EXPECT_EQ(stats.maxHoldNs, 100U);
+
+    counters.reset();
+    stats = counters.getStatistics();
+    EXPECT_EQ(stats.acquisitions, 0U);
+    EXPECT_EQ(stats.totalHoldNs, 0U);
+    EXPECT_EQ(stats.maxWaitNs, 0U);
+}
+
+TEST(InstrumentedLockTest, contendedLock) {
+    kiwix::lock_instrumentation::setEnabled(true);
+    kiwix::LockCounters& counters = kiwix::getLockCounters("InstrumentedLockTest");
+    counters.reset();
+    std::mutex mutex;
+    typedef kiwix::InstrumentedLock<std::mutex> Lock;
+
+    const auto holdTime = std::chrono::milliseconds(50);
+    std::mutex startMutex;
+    std::condition_variable started;
+    bool lockIsHeld = false;
+    std::thread owner([&]() {
+        Lock lock(mutex, counters);
+        {
+            std::lock_guard<std::mutex> l(startMutex);
+            lockIsHeld = true;
+        }
+        started.notify_one();
+        std::this_thread::sleep_for(holdTime);
+    });
+    {
+        std::unique_lock<std::mutex> l(startMutex);
+        started.wait(l, [&]() { return lockIsHeld; });
+    }
+    {
+        // Waits until the owner thread releases the lock
+        Lock lock(mutex, counters);
+    }
+    owner.join();
+
+    auto stats = counters.getStatistics();
+    EXPECT_EQ(stats.acquisitions, 2U);
+    EXPECT_EQ(stats.contentions, 1U);
+    EXPECT_GT(stats.totalWaitNs, 0U);
+    EXPECT_EQ(stats.totalWaitNs, stats.maxWaitNs);
+    EXPECT_GE(stats.maxHoldNs, uint64_t(std::chrono::nanoseconds(holdTime).count()));
+    EXPECT_GE(stats.totalHoldNs, stats.maxHoldNs);
+
+    // Unlocking early is accounted for
+    {
+        Lock lock(mutex, counters);
+        lock.unlock();
+        EXPECT_FALSE(lock.owns_lock());
+        EXPECT_TRUE(mutex.try_lock());
+        mutex.unlock();
+    }
+    EXPECT_EQ(counters.getStatistics().acquisitions, 3U);
+
+    // Nested acquisitions of a recursive mutex are counted once
+    std::recursive_mutex recursiveMutex;
+    {
+        kiwix::InstrumentedLock<std::recursive_mutex> lock1(recursiveMutex, counters);
+        kiwix::InstrumentedLock<std::recursive_mutex> lock2(recursiveMutex, counters);
+    }
+    EXPECT_EQ(counters.getStatistics().acquisitions, 4U);
+
+    // Nothing is recorded when the instrumentation is disabled
+    kiwix::lock_instrumentation::setEnabled(false);
+    EXPECT_FALSE(kiwix::isLockInstrumentationEnabled());
+    EXPECT_TRUE(kiwix::getLockStatistics().empty());
+    {
+        Lock lock(mutex, counters);
+        EXPECT_TRUE(lock.owns_lock());
+        EXPECT_FALSE(mutex.try_lock());
+    }
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+    stats = counters.getStatistics();
+    EXPECT_EQ(stats.acquisitions, 4U);
+    EXPECT_EQ(stats.contentions, 1U);
+}
@@ -3,8 +3,10 @@
 #include "../include/library.h"
 #include "../include/book.h"
 #include "../include/tools.h"
+#include "../src/tools/pathTools.h"
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 
 TEST(ManagerTest, addBookFromPathAndGetIdTest)
 {
@@ -108,3 +110,123 @@ TEST(Manager, reload)
         "raycharles_uncategorized"
   }));
 }
+
+TEST(Manager, readXmlOfLargeLibrary)
+{
+  // Large enough to be parsed by several threads
+  const size_t bookCount = 2000;
+  std::string xml = "<library version=\"1.0\">\n";
+  kiwix::Library::BookIdCollection expectedBookIds;
+  for ( size_t i = 0; i < bookCount; ++i ) {
+    const std::string id = "book" + std::to_string(bookCount - i);
+    xml += "<book id=\"" + id + "\" path=\"" + id + ".zim\""
+           " title=\"Book " + std::to_string(i) + "\" language=\"eng\"/>\n";
+    expectedBookIds.push_back(id);
+  }
+  xml += "</library>\n";
+
+  auto lib = kiwix::Library::create();
+  kiwix::Manager manager(lib);
+  const auto rev = lib->getRevision();
+  EXPECT_TRUE(manager.readXml(xml, true, LIB_ABS_PATH, true));
+
+  // The books are added at once and in the order of the file
+  EXPECT_EQ(rev + 1, lib->getRevision());
+  EXPECT_EQ(lib->filter(kiwix::Filter()), expectedBookIds);
+  const auto book = lib->getBookById("book1");
+  EXPECT_EQ("Book 1999", book.getTitle());
+  EXPECT_EQ(kiwix::computeAbsolutePath(kiwix::removeLastPathElement(LIB_ABS_PATH), "book1.zim"), book.getPath());
+  EXPECT_FALSE(book.isPathValid());
+}
+
+TEST(Manager, readFileUsingSnapshot)
+{
+  const std::string dir = makeTmpDirectory();
+  const std::string libraryPath = kiwix::appendToDirectory(dir, "library.xml");
+  const std::string snapshotPath = libraryPath + ".snapshot";
+  const std::string bookId = "0d0bcd57-d3f6-cb22-44cc-a723ccb4e1b2";
+  ASSERT_TRUE(writeTextFile(libraryPath, sampleLibraryXML));
+
+  const auto readLibrary = [&]() {
+    auto lib = kiwix::Library::create();
+    kiwix::Manager manager(lib);
+    manager.setLibrarySnapshotsEnabled(true);
+    EXPECT_TRUE(manager.readFile(libraryPath, false, true));
+    return lib;
+  };
+
+  // The snapshot is made when the library file is read for the first time
+  auto lib = readLibrary();
+  EXPECT_TRUE(kiwix::fileExists(snapshotPath));
+  EXPECT_EQ("Unit Test", lib->getBookById(bookId).getTitle());
+  EXPECT_FALSE(lib->getBookById(bookId).isPathValid());
+  const std::string snapshot = kiwix::getFileContent(snapshotPath);
+
+  // The books read from the snapshot are the same, except for the
+  // validity of their paths which is checked again
+  ASSERT_TRUE(std::filesystem::create_directory(kiwix::appendToDirectory(dir, "zimfiles")));
+  ASSERT_TRUE(writeTextFile(kiwix::appendToDirectory(dir, UNITTEST_ZIM_PATH), ""));
+  lib = readLibrary();
+  EXPECT_EQ(snapshot, kiwix::getFileContent(snapshotPath));
+  const auto book = lib->getBookById(bookId);
+  EXPECT_EQ("Unit Test", book.getTitle());
+  EXPECT_EQ(kiwix::appendToDirectory(dir, UNITTEST_ZIM_PATH), book.getPath());
+  EXPECT_EQ("eng", book.getCommaSeparatedLanguages());
+  EXPECT_EQ("unittest;wikipedia", book.getTags());
+  EXPECT_EQ(678U*1024, book.getSize());
+  EXPECT_TRUE(book.isPathValid());
+
+  // The snapshot is made again after the library file changes
+  std::string updatedLibraryXML = sampleLibraryXML;
+  updatedLibraryXML.replace(updatedLibraryXML.find("Unit Test"), 9, "Unit Tests");
+  ASSERT_TRUE(writeTextFile(libraryPath, updatedLibraryXML));
+  lib = readLibrary();
+  EXPECT_EQ("Unit Tests", lib->getBookById(bookId).getTitle());
+  EXPECT_NE(snapshot, kiwix::getFileContent(snapshotPath));
+
+  // An invalid snapshot is ignored
+  ASSERT_TRUE(writeTextFile(snapshotPath, snapshot.substr(0, snapshot.size() - 1)));
+  lib = readLibrary();
+  EXPECT_EQ("Unit Tests", lib->getBookById(bookId).getTitle());
+}
+
+TEST(Manager, zimMetadataCache)
+{
+  const std::string dir = makeTmpDirectory();
+  const std::string zimPath = kiwix::appendToDirectory(dir, "example.zim");
+  const std::string cachePath = kiwix::appendToDirectory(dir, "zim_metadata.cache");
+  ASSERT_TRUE(std::filesystem::copy_file("./test/example.zim", zimPath));
+
+  const auto addBook = [&](bool useCache) -> std::string {
+    auto lib = kiwix::Library::create();
+    kiwix::Manager manager(lib);
+    if (useCache) {
+      manager.setZimMetadataCachePath(cachePath);
+    }
+    const auto bookId = manager.addBookFromPathAndGetId(zimPath);
+    return bookId.empty() ? "" : bookId + "/" + lib->getBookById(bookId).getTitle();
+  };
+
+  // The cache is saved when the manager is destroyed
+  const std::string book = addBook(true);
+  ASSERT_NE("", book);
+  EXPECT_TRUE(kiwix::fileExists(cachePath));
+
+  // Overwrite the ZIM file without changing its size, mtime and inode
+  const auto mtime = std::filesystem::last_write_time(zimPath);
+  std::string content = kiwix::getFileContent(zimPath);
+  std::fill(content.begin(), content.end(), 'x');
+  {
+    std::fstream zimFile(zimPath, std::ios::in | std::ios::out | std::ios::binary);
+    zimFile.write(content.data(), content.size());
+  }
+  std::filesystem::last_write_time(zimPath, mtime);
+
+  // The (now invalid) ZIM file isn't opened when its book is in the cache
+  EXPECT_EQ("", addBook(false));
+  EXPECT_EQ(book, addBook(true));
+
+  // Modified ZIM files are read again
+  std::filesystem::last_write_time(zimPath, mtime + std::chrono::seconds(1));
+  EXPECT_EQ("", addBook(true));
+}
@@ -258,3 +258,89 @@ TEST(networkTools, getBestPublicIps)
   std::cout << "getBestPublicIps(): " << "[" << kiwix::getBestPublicIps().addr << ", " << kiwix::getBestPublicIps().addr6 << "]" << std::endl;
   std::cout << "getBestPublicIp(): " << kiwix::getBestPublicIp() << std::endl;
 }
+
+#include "../src/tools/cancellation_token.h"
+
+TEST(CancellationToken, cancel)
+{
+  kiwix::CancellationToken token;
+  EXPECT_FALSE(token.isCancelled());
+  EXPECT_NO_THROW(token.throwIfCancelled());
+
+  token.cancel();
+  EXPECT_TRUE(token.isCancelled());
+  EXPECT_THROW(token.throwIfCancelled(), kiwix::OperationCancelled);
+
+  // Cancellation is final
+  token.cancel();
+  EXPECT_TRUE(token.isCancelled());
+}
+
+TEST(CancellationToken, probe)
+{
+  kiwix::CancellationToken token;
+  int probeCallCount = 0;
+  bool peerGone = false;
+  token.setProbe([&]() { ++probeCallCount; return peerGone; },
+                 std::chrono::hours(1));
+
+  // The probe is called at most once per interval
+  EXPECT_FALSE(token.isCancelled());
+  EXPECT_FALSE(token.isCancelled());
+  EXPECT_NO_THROW(token.throwIfCancelled());
+  EXPECT_EQ(probeCallCount, 1);
+
+  token.setProbe([&]() { ++probeCallCount; return peerGone; },
+                 std::chrono::seconds(0));
+  peerGone = true;
+  EXPECT_TRUE(token.isCancelled());
+  EXPECT_EQ(probeCallCount, 2);
+
+  // The probe is no longer called once the token is cancelled
+  EXPECT_THROW(token.throwIfCancelled(), kiwix::OperationCancelled);
+  EXPECT_EQ(probeCallCount, 2);
+}
+
+TEST(CancellationToken, clearProbe)
+{
+  kiwix::CancellationToken token;
+  int probeCallCount = 0;
+  token.setProbe([&]() { ++probeCallCount; return true; },
+                 std::chrono::seconds(0));
+  token.clearProbe();
+  EXPECT_FALSE(token.isCancelled());
+  EXPECT_EQ(probeCallCount, 0);
+}
+
+#include "../src/tools/worker_pool.h"
+
+#include <atomic>
+
+TEST(WorkerPool, processInSlices)
+{
+  const auto sliceToString = [](size_t first, size_t last) {
+    return std::to_string(first) + "-" + std::to_string(last);
+  };
+  typedef std::vector<std::string> Slices;
+
+  // The range isn't split without a pool or if it is too small
+  EXPECT_EQ(kiwix::processInSlices(nullptr, 100, 10, sliceToString), Slices({"0-100"}));
+  kiwix::WorkerPool pool(3);
+  EXPECT_EQ(kiwix::processInSlices(&pool, 19, 10, sliceToString), Slices({"0-19"}));
+  EXPECT_EQ(kiwix::processInSlices(&pool, 0, 10, sliceToString), Slices({"0-0"}));
+
+  // The results are in the order of the slices
+  EXPECT_EQ(kiwix::processInSlices(&pool, 30, 10, sliceToString), Slices({"0-10", "10-20", "20-30"}));
+  EXPECT_EQ(kiwix::processInSlices(&pool, 1000, 10, sliceToString), Slices({"0-250", "250-500", "500-750", "750-1000"}));
+
+  // All the slices are processed before an exception is rethrown
+  std::atomic<int> processedSliceCount{0};
+  EXPECT_THROW(kiwix::processInSlices(&pool, 100, 10, [&](size_t first, size_t) {
+      ++processedSliceCount;
+      if ( first == 0 ) {
+        throw std::runtime_error("first slice");
+      }
+      return 0;
+    }), std::runtime_error);
+  EXPECT_EQ(processedSliceCount.load(), 4);
+}
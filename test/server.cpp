@@ -7,11 +7,15 @@
 #include "server_testing_tools.h"
 
 #include "../src/tools/stringTools.h"
+#include "../src/tools/instrumented_lock.h"
 
 #include "testing_tools.h"
 
 #include "../src/server/microhttpd_wrapper.h" // for MHD_VERSION
 
+#include <atomic>
+#include <thread>
+
 using namespace kiwix::testing;
 
 const std::string ROOT_PREFIX("/ROOT%23%3F");
@@ -1764,6 +1768,25 @@ TEST_F(ServerTest, NonEndpointUrlsAreRedirectedToContentUrls)
   }
 }
 
+TEST_F(ServerTest, LockStatistics)
+{
+  // The endpoint exists only if the lock instrumentation is enabled
+  kiwix::lock_instrumentation::setEnabled(false);
+  EXPECT_EQ(302, zfs1_->GET("/ROOT%23%3F/stats/locks")->status);
+
+  kiwix::lock_instrumentation::setEnabled(true);
+  kiwix::resetLockStatistics();
+  EXPECT_EQ(200, zfs1_->GET("/ROOT%23%3F/catalog/v2/entries")->status);
+  const auto r = zfs1_->GET("/ROOT%23%3F/stats/locks");
+  kiwix::lock_instrumentation::setEnabled(false);
+
+  EXPECT_EQ(200, r->status);
+  EXPECT_EQ("application/json; charset=utf-8", r->get_header_value("Content-Type"));
+  EXPECT_FALSE(r->has_header("ETag"));
+  EXPECT_EQ(r->body.substr(0, 2), "[\n");
+  EXPECT_NE(std::string::npos, r->body.find(R"({"name": "Library::m_mutex", "acquisitions": )")) << r->body;
+}
+
 TEST_F(ServerTest, RedirectionsToURLsWithSpecialSymbols)
 {
   auto g = zfs1_->GET("/ROOT%23%3F/content/corner_cases%23%26/c_sharp.html");
@@ -1836,6 +1859,20 @@ TEST_F(ServerTest, HeadersAreTheSameInResponsesToHeadAndGetRequests)
   }
 }
 
+TEST_F(ServerTest, HeadersAreTheSameInResponsesToHeadAndGetRequestsForCompressedContent)
+{
+  const httplib::Headers acceptGzip{ {"Accept-Encoding", "gzip"} };
+  for ( const Resource& res : all200Resources() ) {
+    // The first HEAD request may have to compress the content, while
+    // the second one can reuse the size of the compressed content.
+    httplib::Headers h1 = zfs1_->HEAD(res.url, acceptGzip)->headers;
+    httplib::Headers g = zfs1_->GET(res.url, acceptGzip)->headers;
+    httplib::Headers h2 = zfs1_->HEAD(res.url, acceptGzip)->headers;
+    EXPECT_EQ(invariantHeaders(g), invariantHeaders(h1)) << res;
+    EXPECT_EQ(invariantHeaders(g), invariantHeaders(h2)) << res;
+  }
+}
+
 TEST_F(ServerTest, CacheControlOfZimContent)
 {
   for ( const Resource& res : all200Resources() ) {
@@ -2303,6 +2340,42 @@ TEST_F(ServerTest, suggestions_in_range)
   }
 }
 
+TEST_F(ServerTest, concurrentRenderingOfTemplates)
+{
+  // The same pre-parsed templates (of the suggestions and of the error
+  // pages) are rendered by all the threads of the server at the same time
+  const std::vector<std::string> urls{
+    "/ROOT%23%3F/suggest?content=zimfile&term=thing",
+    "/ROOT%23%3F/suggest?content=zimfile&term=old%20sun",
+    "/ROOT%23%3F/suggest?content=zimfile&term=ray&count=20",
+    "/ROOT%23%3F/content/zimfile/A/nosuchentry",
+    "/ROOT%23%3F/content/nosuchbook/A/index"
+  };
+  std::vector<std::string> expectedBodies;
+  for ( const auto& url : urls ) {
+    expectedBodies.push_back(zfs1_->GET(url.c_str())->body);
+  }
+
+  std::vector<std::thread> clients;
+  std::atomic<int> mismatchCount{0};
+  for ( int i = 0; i < 8; ++i ) {
+    clients.emplace_back([&, i]() {
+      httplib::Client client("127.0.0.1", SERVER_PORT);
+      for ( size_t j = 0; j < 50; ++j ) {
+        const size_t k = (i + j) % urls.size();
+        const auto r = client.Get(urls[k].c_str());
+        if ( !r || r->body != expectedBodies[k] ) {
+          ++mismatchCount;
+        }
+      }
+    });
+  }
+  for ( auto& client : clients ) {
+    client.join();
+  }
+  EXPECT_EQ(mismatchCount.load(), 0);
+}
+
 TEST_F(ServerTest, viewerSettings)
 {
   const auto JS_CONTENT_TYPE = "application/javascript; charset=utf-8";
@@ -1702,4 +1702,10 @@ TEST(ServerSearchTest, bookSelectionNegativeTests)
     EXPECT_EQ(r->status, 400);
     EXPECT_EQ(r->body, noBookFoundErrorHtml(url));
   }
+
+  {
+    // invalid values of the books.filter.* parameters are rejected
+    const auto r = zfs.GET("/ROOT%23%3F/search?pattern=travel&books.filter.dateto=2023-1");
+    EXPECT_EQ(r->status, 400);
+  }
 }
@@ -63,6 +63,7 @@ public: // types
     BLOCK_EXTERNAL_LINKS = 1 << 3,
     NO_NAME_MAPPER       = 1 << 4,
     CATALOG_ONLY_MODE    = 1 << 5,
+    VERBOSE              = 1 << 6,
 
     WITH_TASKBAR_AND_LIBRARY_BUTTON = WITH_TASKBAR | WITH_LIBRARY_BUTTON,
 
@@ -74,6 +75,7 @@ public: // types
     std::string root = "ROOT#?";
     std::string contentServerUrl = "";
     Options options = DEFAULT_OPTIONS;
+    int opdsStreamingThreshold = 500; // same default as kiwix::Server
 
     Cfg(Options opts = DEFAULT_OPTIONS) : options(opts) {}
   };
@@ -147,12 +149,13 @@ void ZimFileServer::run(int serverPort, std::string indexTemplateString)
   server->setAddress(address);
   server->setPort(serverPort);
   server->setNbThreads(2);
-  server->setVerbose(false);
+  server->setVerbose(cfg.options & VERBOSE);
   server->setTaskbar(cfg.options & WITH_TASKBAR, cfg.options & WITH_LIBRARY_BUTTON);
   server->setBlockExternalLinks(cfg.options & BLOCK_EXTERNAL_LINKS);
   server->setMultiZimSearchLimit(3);
   server->setCatalogOnlyMode(cfg.options & CATALOG_ONLY_MODE);
   server->setContentServerUrl(cfg.contentServerUrl);
+  server->setOPDSStreamingThreshold(cfg.opdsStreamingThreshold);
   if (!indexTemplateString.empty()) {
     server->setIndexTemplateString(indexTemplateString);
   }